@@ -0,0 +1,147 @@
+/* bit_atomic.h
+ * definitions for writing bitfields to buffers shared between threads,
+ * so that fields sharing a byte or a word can be written concurrently.
+ */
+
+#ifndef __BIT_ATOMIC_H__
+#define __BIT_ATOMIC_H__
+
+#pragma warning(disable : 26451)
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "bit_bits.h"
+
+/********************************************************************
+ * utility functions for atomic access to 64-bit words
+ */
+
+/* atomically load, or, and and compare-exchange an aligned 64-bit word
+ * ptr ... pointer to the word
+ * val ... operand
+ * exp ... expected value of the word
+ * des ... desired value of the word
+ * the compare-exchange returns the previous value of the word
+ */
+#if defined(_MSC_VER)
+#define BIT_ATOMIC_LOAD64(ptr) ((uint64_t)*(volatile long long*)(ptr))
+#define BIT_ATOMIC_OR64(ptr,val) ((void)_InterlockedOr64((volatile long long*)(ptr), (long long)(val)))
+#define BIT_ATOMIC_AND64(ptr,val) ((void)_InterlockedAnd64((volatile long long*)(ptr), (long long)(val)))
+#define BIT_ATOMIC_CAS64(ptr,exp,des) \
+    ((uint64_t)_InterlockedCompareExchange64((volatile long long*)(ptr), (long long)(des), (long long)(exp)))
+#else
+#define BIT_ATOMIC_LOAD64(ptr) __atomic_load_n((uint64_t*)(ptr), __ATOMIC_RELAXED)
+#define BIT_ATOMIC_OR64(ptr,val) ((void)__atomic_fetch_or((uint64_t*)(ptr), (uint64_t)(val), __ATOMIC_SEQ_CST))
+#define BIT_ATOMIC_AND64(ptr,val) ((void)__atomic_fetch_and((uint64_t*)(ptr), (uint64_t)(val), __ATOMIC_SEQ_CST))
+#define BIT_ATOMIC_CAS64(ptr,exp,des) \
+    __sync_val_compare_and_swap((uint64_t*)(ptr), (uint64_t)(exp), (uint64_t)(des))
+#endif
+
+/* convert a mask or value of the bitstream (big-endian, MSB first) to the
+ *     representation of the 64-bit word holding it in memory
+ */
+#if BYTE_HOST_BIG_ENDIAN
+#define BIT_ATOMIC_NATIVE(val) ((uint64_t)(val))
+#else
+#define BIT_ATOMIC_NATIVE(val) ((uint64_t)BYTE_SWAP64(val))
+#endif
+
+/* atomically replace the bits 'mask' of word 'ptr' by the same bits of 'val';
+ *     a single fetch_or / fetch_and when the new bits are all ones / all
+ *     zeros, otherwise a compare-exchange loop
+ * ptr ... pointer to the aligned word
+ * mask .. bits to replace, in memory representation
+ * val ... new bits, in memory representation
+ */
+static inline void bit_atomic_merge64(uint64_t* ptr, uint64_t mask, uint64_t val)
+{
+    val &= mask;
+    if (val == mask)
+    {
+        BIT_ATOMIC_OR64(ptr, val);
+    }
+    else if (val == 0)
+    {
+        BIT_ATOMIC_AND64(ptr, ~mask);
+    }
+    else
+    {
+        uint64_t old = BIT_ATOMIC_LOAD64(ptr);
+        for (;;)
+        {
+            uint64_t prev = BIT_ATOMIC_CAS64(ptr, old, (old & ~mask) | val);
+            if (prev == old)
+                break;
+            old = prev;
+        }
+    }
+}
+
+/********************************************************************
+ * bitfield functions - for writing bitfields to a shared buffer atomically.
+ *     the buffer must be 8-byte aligned and its size a multiple of 8 bytes,
+ *     as it is updated by whole 64-bit words; bits outside the field are
+ *     never changed, even transiently. the pointer is not incremented, since
+ *     that would break the alignment; advance the bit address instead.
+ */
+
+/* write a single bit atomically by a single fetch_or / fetch_and
+ * buf ... 8-byte aligned buffer
+ * bit ... bit address
+ * val ... value to write
+ */
+static inline void bit_wflag_atomic(void* buf, uint64_t bit, uint64_t val)
+{
+    uint64_t* ptr = (uint64_t*)buf + (bit >> 6);
+    uint64_t mask = BIT_ATOMIC_NATIVE((uint64_t)1 << (63 - (bit & 0x3f)));
+    if (val & 1)
+        BIT_ATOMIC_OR64(ptr, mask);
+    else
+        BIT_ATOMIC_AND64(ptr, ~mask);
+}
+
+/* write value in a bitfield with custom length up to 64 bits atomically; a
+ *     field crossing a word boundary is written by one update per word
+ * buf ... 8-byte aligned buffer
+ * bit ... bit address
+ * len ... length of bitfield
+ * val ... value to write
+ */
+static inline void bit_wbits_atomic(void* buf, uint64_t bit, int len, uint64_t val)
+{
+    uint64_t* ptr = (uint64_t*)buf + (bit >> 6);
+    int first = (int)(bit & 0x3f);
+    int rest = first + len - 64;
+    val &= MASK64(len);
+
+    if (rest <= 0)
+    {
+        bit_atomic_merge64(ptr, BIT_ATOMIC_NATIVE(MASK64(len) << -rest), BIT_ATOMIC_NATIVE(val << -rest));
+    }
+    else
+    {
+        bit_atomic_merge64(ptr, BIT_ATOMIC_NATIVE(MASK64(64 - first)), BIT_ATOMIC_NATIVE(val >> rest));
+        bit_atomic_merge64(ptr + 1, BIT_ATOMIC_NATIVE(MASK64(rest) << (64 - rest)), BIT_ATOMIC_NATIVE(val << (64 - rest)));
+    }
+}
+
+/* write a single bit atomically
+ * buf ... 8-byte aligned buffer
+ * bit ... bit address
+ * val ... value to write
+ */
+#define BIT_WFLAG_ATOMIC(buf,bit,val) \
+    bit_wflag_atomic((void*)(buf), (uint64_t)(bit), (uint64_t)(val))
+
+/* write value in a bitfield with custom length up to 64 bits atomically
+ * buf ... 8-byte aligned buffer
+ * bit ... bit address
+ * len ... length of bitfield
+ * val ... value to write
+ */
+#define BIT_WBITS_ATOMIC(buf,bit,len,val) \
+    bit_wbits_atomic((void*)(buf), (uint64_t)(bit), (int)(len), (uint64_t)(val))
+
+#endif /* __BIT_ATOMIC_H__ */
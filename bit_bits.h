@@ -3,6 +3,9 @@
 
 #pragma warning(disable : 26451)
 
+#include <cassert>
+#include <cstddef>
+
 #include "byte_bytes.h"
 
 /********************************************************************
@@ -55,6 +58,26 @@
         (bit) = OFFSET((bit) + (len)); \
     } while (0)
 
+/********************************************************************
+ * instrumentation hooks - counting the calls of the bitfield functions
+ *     when BIT_INSTRUMENT is defined (see bit_stats.h), nothing otherwise
+ */
+
+#if defined(BIT_INSTRUMENT)
+#include "bit_stats.h"
+#define BIT_STAT_READ(buf,bit,bytes) bit_stats_read((const uint8_t*)(buf) + ADDR(bit), bytes)
+#define BIT_STAT_WRITE(bytes) bit_stats_write(bytes)
+#define BIT_STAT_PADDED_READ() bit_stats_padded_read()
+#define BIT_STAT_PADDED_WRITE() bit_stats_padded_write()
+#define BIT_STAT_COPY(len) bit_stats_copy((uint64_t)(len))
+#else
+#define BIT_STAT_READ(buf,bit,bytes) ((void)0)
+#define BIT_STAT_WRITE(bytes) ((void)0)
+#define BIT_STAT_PADDED_READ() ((void)0)
+#define BIT_STAT_PADDED_WRITE() ((void)0)
+#define BIT_STAT_COPY(len) ((void)0)
+#endif
+
 /* extract a single bit
  * buf ... buffer
  * bit ... bit address
@@ -135,6 +158,7 @@
 #define BIT_BITS(buf,bit,len,ret) \
     do { \
         int __involved_bytes__ = INVOLVED_BYTES(bit, len); \
+        BIT_STAT_READ(buf, bit, __involved_bytes__); \
              if (__involved_bytes__ == 1) (ret) =  BIT_8(buf, bit, len); \
         else if (__involved_bytes__ == 2) (ret) = BIT_16(buf, bit, len); \
         else if (__involved_bytes__ == 3) (ret) = BIT_24(buf, bit, len); \
@@ -360,6 +384,7 @@ static inline _RetTy bit_bits_inc(_BufTy & buf, _BitTy & bit, _LenTy len)
 #define BIT_WBITS(buf,bit,len,val) \
     do { \
         int __involved_bytes__ = INVOLVED_BYTES(bit, len); \
+        BIT_STAT_WRITE(__involved_bytes__); \
              if (__involved_bytes__ == 1)  BIT_W8(buf, bit, len, val); \
         else if (__involved_bytes__ == 2) BIT_W16(buf, bit, len, val); \
         else if (__involved_bytes__ == 3) BIT_W24(buf, bit, len, val); \
@@ -384,6 +409,139 @@ static inline _RetTy bit_bits_inc(_BufTy & buf, _BitTy & bit, _LenTy len)
         BIT_INCREMENT(buf, bit, len); \
     } while (0)
 
+/********************************************************************
+ * bitfield functions - for appending bitfields to a zeroed buffer.
+ *     the bitfield and the bits following it in its last byte must be
+ *     zero, e.g. a buffer cleared by memset or calloc and written in
+ *     ascending bit order. only the first byte is merged (OR), the other
+ *     bytes are stored without loading and masking; debug builds check
+ *     the precondition
+ */
+
+/* check that a bitfield and the bits following it in its last byte are zero
+ * buf ... buffer
+ * bit ... bit address
+ * len ... length of bitfield
+ */
+#if !defined(NDEBUG)
+#define BIT_ZERO_CHECK(buf,bit,len) \
+    do { \
+        uint64_t __zero__; \
+        BIT_BITS(buf, bit, len, __zero__); \
+        assert(__zero__ == 0 && (BYTE_8(buf, ADDR((bit) + (len) - 1)) & MASK8(SHIFT(bit, len))) == 0); \
+    } while (0)
+#else
+#define BIT_ZERO_CHECK(buf,bit,len) ((void)0)
+#endif
+
+/* write value in a zeroed bitfield with custom length up to 64 bits
+ * buf ... buffer
+ * bit ... bit address
+ * len ... length of bitfield
+ * val ... value to write
+ */
+#define BIT_WBITS_ZERO(buf,bit,len,val) \
+    do { \
+        BIT_ZERO_CHECK(buf, bit, len); \
+        int __involved_bytes__ = INVOLVED_BYTES(bit, len); \
+        int __shift__ = SHIFT(bit, len); \
+        uint64_t __val__ = (uint64_t)(val) & MASK64(len); \
+        uint8_t* __first__ = (uint8_t*)(buf) + ADDR(bit); \
+        BIT_STAT_WRITE(__involved_bytes__); \
+        if (__involved_bytes__ == 9) { \
+            __first__[0] |= (uint8_t)(__val__ >> (64 - __shift__)); \
+            BYTE_64_STORE(__first__, 1, __val__ << __shift__); \
+        } \
+        else { \
+            uint64_t __word__ = __val__ << __shift__; \
+            __first__[0] |= (uint8_t)(__word__ >> ((__involved_bytes__ - 1) << 3)); \
+            BYTE_WBYTES(__first__ + 1, __involved_bytes__ - 1, __word__); \
+        } \
+    } while (0)
+
+/* write value in a zeroed bitfield with custom length up to 64 bits and
+ *     increment buffer pointer 'buf' and bit address 'bit'
+ * buf ... buffer
+ * bit ... bit address
+ * len ... length of bitfield
+ * val ... value to write
+ */
+#define BIT_WBITS_ZERO_INC(buf,bit,len,val) \
+    do { \
+        BIT_WBITS_ZERO(buf, bit, len, val); \
+        BIT_INCREMENT(buf, bit, len); \
+    } while (0)
+
+/********************************************************************
+ * bitfield functions - for accessing bitfields of padded buffers with a
+ *     single unaligned 64-bit load (and store); the buffer must provide
+ *     BYTE_PADDING bytes past the byte holding the last bit of the field
+ */
+
+/* the longest bitfield which always fits in the 8 bytes loaded at ADDR(bit) */
+#define BIT_PADDED_MAX_LEN 57
+
+/* extract bitfield with custom length up to 57 bits from a padded buffer
+ * buf ... buffer
+ * bit ... bit address
+ * len ... length of bitfield
+ */
+#define BIT_PADDED(buf,bit,len) \
+    ((BYTE_64_LOAD(buf, ADDR(bit)) << OFFSET(bit)) >> (64 - (len)))
+
+/* extract bitfield with custom length up to 57 bits from a padded buffer
+ * buf ... buffer
+ * bit ... bit address
+ * len ... length of bitfield
+ * ret ... result variable
+ */
+#define BIT_BITS_PADDED(buf,bit,len,ret) \
+    do { \
+        BIT_STAT_PADDED_READ(); \
+        (ret) = BIT_PADDED(buf, bit, len); \
+    } while (0)
+
+/* extract bitfield with custom length up to 57 bits from a padded buffer and
+ *     increment buffer pointer 'buf' and bit address 'bit'
+ * buf ... buffer
+ * bit ... bit address
+ * len ... length of bitfield
+ * ret ... result variable
+ */
+#define BIT_BITS_PADDED_INC(buf,bit,len,ret) \
+    do { \
+        BIT_BITS_PADDED(buf, bit, len, ret); \
+        BIT_INCREMENT(buf, bit, len); \
+    } while (0)
+
+/* write value in a bitfield with custom length up to 57 bits of a padded buffer
+ * buf ... buffer
+ * bit ... bit address
+ * len ... length of bitfield
+ * val ... value to write
+ */
+#define BIT_WBITS_PADDED(buf,bit,len,val) \
+    do { \
+        BIT_STAT_PADDED_WRITE(); \
+        int __shift__ = 64 - OFFSET(bit) - (len); \
+        uint64_t __mask__ = MASK64(len) << __shift__; \
+        uint64_t __word__ = BYTE_64_LOAD(buf, ADDR(bit)); \
+        BYTE_64_STORE(buf, ADDR(bit), (__word__ & ~__mask__) | (((uint64_t)(val) << __shift__) & __mask__)); \
+    } while (0)
+
+/* write value in a bitfield with custom length up to 57 bits of a padded buffer and
+ *     increment buffer pointer 'buf' and bit address 'bit'
+ * buf ... buffer
+ * bit ... bit address
+ * len ... length of bitfield
+ * val ... value to write
+ */
+#define BIT_WBITS_PADDED_INC(buf,bit,len,val) \
+    do { \
+        BIT_WBITS_PADDED(buf, bit, len, val); \
+        BIT_INCREMENT(buf, bit, len); \
+    } while (0)
+
 /********************************************************************
  * Functions for writing bits with custom length from a source to a
  *     destination buffer
@@ -401,6 +559,7 @@ static inline _RetTy bit_bits_inc(_BufTy & buf, _BitTy & bit, _LenTy len)
         uint64_t __bin__ = 0; \
         int __dst_bit__ = (int)(bit); \
         int __rem_len__ = (int)(len); \
+        BIT_STAT_COPY(__rem_len__); \
         int __src_bit__ = (int)(src_bit); \
         while (__rem_len__ > 64) { \
             BIT_BITS(src, __src_bit__, 64, __bin__); \
@@ -446,6 +605,7 @@ static inline _RetTy bit_bits_inc(_BufTy & buf, _BitTy & bit, _LenTy len)
         uint64_t __bin__ = 0; \
         int __src_bit__ = (int)(bit); \
         int __rem_len__ = (int)(len); \
+        BIT_STAT_COPY(__rem_len__); \
         int __dst_bit__ = (int)(dst_bit); \
         while (__rem_len__ > 64) { \
             BIT_BITS(buf, __src_bit__, 64, __bin__); \
@@ -474,4 +634,296 @@ static inline _RetTy bit_bits_inc(_BufTy & buf, _BitTy & bit, _LenTy len)
         BIT_INCREMENT(buf, bit, len); \
     } while (0)
 
+/********************************************************************
+ * Functions for copying bits with custom length to a zeroed destination
+ *     buffer, as BIT_WBITS_ZERO
+ */
+
+/* write bits with custom length from a source buffer 'src' to a zeroed range
+ * buf ... destination buffer
+ * bit ... bit address
+ * len ... length of bitfield
+ * src ... source buffer
+ * src_bit source bit address
+ */
+#define BIT_WBITS_BUFFER_ZERO(buf,bit,len,src,src_bit) \
+    do { \
+        uint64_t __bin__ = 0; \
+        int __dst_bit__ = (int)(bit); \
+        int __rem_len__ = (int)(len); \
+        int __src_bit__ = (int)(src_bit); \
+        BIT_STAT_COPY(__rem_len__); \
+        while (__rem_len__ > 64) { \
+            BIT_BITS(src, __src_bit__, 64, __bin__); \
+            BIT_WBITS_ZERO(buf, __dst_bit__, 64, __bin__); \
+            __src_bit__ += 64; \
+            __dst_bit__ += 64; \
+            __rem_len__ -= 64; \
+        } \
+        if (__rem_len__ > 0) { \
+            BIT_BITS(src, __src_bit__, __rem_len__, __bin__); \
+            BIT_WBITS_ZERO(buf, __dst_bit__, __rem_len__, __bin__); \
+        } \
+    } while (0)
+
+/* write bits with custom length from a source buffer 'src' to a zeroed range
+ *     and increment destination buffer pointer 'buf' and bit address 'bit'
+ * buf ... destination buffer
+ * bit ... bit address
+ * len ... length of bitfield
+ * src ... source buffer
+ * src_bit source bit address
+ */
+#define BIT_WBITS_BUFFER_ZERO_INC(buf,bit,len,src,src_bit) \
+    do { \
+        BIT_WBITS_BUFFER_ZERO(buf, bit, len, src, src_bit); \
+        BIT_INCREMENT(buf, bit, len); \
+    } while (0)
+
+/* extract bits with custom length to a zeroed range of a destination buffer 'dst'
+ * buf ... source buffer
+ * bit ... bit address
+ * len ... length of bitfield
+ * dst ... destination buffer
+ * dst_bit destination bit address
+ */
+#define BIT_BITS_BUFFER_ZERO(buf,bit,len,dst,dst_bit) \
+    do { \
+        uint64_t __bin__ = 0; \
+        int __src_bit__ = (int)(bit); \
+        int __rem_len__ = (int)(len); \
+        int __dst_bit__ = (int)(dst_bit); \
+        BIT_STAT_COPY(__rem_len__); \
+        while (__rem_len__ > 64) { \
+            BIT_BITS(buf, __src_bit__, 64, __bin__); \
+            BIT_WBITS_ZERO(dst, __dst_bit__, 64, __bin__); \
+            __src_bit__ += 64; \
+            __dst_bit__ += 64; \
+            __rem_len__ -= 64; \
+        } \
+        if (__rem_len__ > 0) { \
+            BIT_BITS(buf, __src_bit__, __rem_len__, __bin__); \
+            BIT_WBITS_ZERO(dst, __dst_bit__, __rem_len__, __bin__); \
+        } \
+    } while (0)
+
+/* extract bits with custom length to a zeroed range of a destination buffer
+ *     'dst' and increment source buffer pointer 'buf' and bit address 'bit'
+ * buf ... source buffer
+ * bit ... bit address
+ * len ... length of bitfield
+ * dst ... destination buffer
+ * dst_bit destination bit address
+ */
+#define BIT_BITS_BUFFER_ZERO_INC(buf,bit,len,dst,dst_bit) \
+    do { \
+        BIT_BITS_BUFFER_ZERO(buf, bit, len, dst, dst_bit); \
+        BIT_INCREMENT(buf, bit, len); \
+    } while (0)
+
+/********************************************************************
+ * Functions for packing and unpacking arrays of values to and from
+ *     consecutive bitfields with the same length
+ */
+
+/* write 'n' values of array 'src' to consecutive bitfields with length 'len'
+ *     (up to 64 bits); the bits are collected in a 64-bit accumulator and
+ *     written 8 bytes at a time, only the last partial byte is merged
+ * buf ... destination buffer
+ * bit ... bit address of the first bitfield
+ * len ... length of each bitfield
+ * src ... source array
+ * n ..... number of values
+ */
+template<typename _ValTy, typename _BufTy, typename _BitTy, typename _LenTy>
+static inline void bit_pack(_BufTy buf, _BitTy bit, _LenTy len, const _ValTy* src, std::size_t n)
+{
+    const int width = (int)len;
+    const uint64_t mask = MASK64(width);
+    uint8_t* out = (uint8_t*)(buf) + ADDR(bit);
+
+    /* start with the untouched leading bits of the first byte */
+    int acc_len = (int)OFFSET(bit);
+    uint64_t acc = (acc_len != 0) ? ((uint64_t)BYTE_8(out, 0) >> (8 - acc_len)) : 0;
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        uint64_t val = (uint64_t)src[i] & mask;
+        if (acc_len + width <= 64)
+        {
+            acc = ((width < 64) ? (acc << width) : 0) | val;
+            acc_len += width;
+        }
+        else
+        {
+            int head_len = 64 - acc_len;
+            BYTE_64_STORE(out, 0, (acc << head_len) | (val >> (width - head_len)));
+            out += 8;
+            acc = val & MASK64(width - head_len);
+            acc_len = width - head_len;
+        }
+
+        if (acc_len == 64)
+        {
+            BYTE_64_STORE(out, 0, acc);
+            out += 8;
+            acc = 0;
+            acc_len = 0;
+        }
+    }
+
+    if (acc_len > 0)
+        BIT_WBITS(out, 0, acc_len, acc);
+}
+
+/* extract 'n' consecutive bitfields with length 'len' (up to 64 bits) to array
+ *     'dst'; the buffer is read 8 bytes at a time and never past the byte
+ *     holding the last bit
+ * buf ... source buffer
+ * bit ... bit address of the first bitfield
+ * len ... length of each bitfield
+ * dst ... destination array
+ * n ..... number of values
+ */
+template<typename _ValTy, typename _BufTy, typename _BitTy, typename _LenTy>
+static inline void bit_unpack(_BufTy buf, _BitTy bit, _LenTy len, _ValTy* dst, std::size_t n)
+{
+    if (n == 0)
+        return;
+
+    const int width = (int)len;
+    const uint8_t* in = (const uint8_t*)(buf) + ADDR(bit);
+    const uint8_t* end = (const uint8_t*)(buf) + ADDR((uint64_t)(bit) + (uint64_t)width * n + 7);
+
+    auto load = [&in, end]() -> uint64_t {
+        uint64_t word;
+        if (end - in >= 8)
+        {
+            word = BYTE_64_LOAD(in, 0);
+        }
+        else
+        {
+            uint8_t tail[8] = { 0 };
+            (void)memcpy(tail, in, (std::size_t)(end - in));
+            word = BYTE_64_LOAD(tail, 0);
+        }
+        in += 8;
+        return word;
+    };
+
+    /* 'acc' holds 'acc_len' unread bits, aligned to its MSB */
+    uint64_t acc = load() << OFFSET(bit);
+    int acc_len = 64 - (int)OFFSET(bit);
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (width <= acc_len)
+        {
+            dst[i] = (_ValTy)(acc >> (64 - width));
+            acc = (width < 64) ? (acc << width) : 0;
+            acc_len -= width;
+        }
+        else
+        {
+            int tail_len = width - acc_len;
+            uint64_t word = load();
+            dst[i] = (_ValTy)((acc >> (64 - width)) | (word >> (64 - tail_len)));
+            acc = (tail_len < 64) ? (word << tail_len) : 0;
+            acc_len = 64 - tail_len;
+        }
+    }
+}
+
+/********************************************************************
+ * Functions for concatenating bitstreams
+ */
+
+/* a fragment of a bitstream: 'len' bits at bit address 'bit' of buffer 'buf' */
+struct BitFragment
+{
+    const void* buf;
+    uint64_t bit;
+    uint64_t len;
+};
+
+/* write 'n' fragments one after the other; the fragments are read up to 56
+ *     bits per 8-byte load (never past the byte holding their last bit) and
+ *     streamed through a single 64-bit accumulator written 8 bytes at a
+ *     time, so only the first and the last byte of the output are merged.
+ *     the fragments must not overlap the output
+ * buf ... destination buffer
+ * bit ... bit address of the output
+ * frags . fragments
+ * n ..... number of fragments
+ * returns the bit address following the output
+ */
+template<typename _BufTy, typename _BitTy>
+static inline uint64_t concat_bits(_BufTy buf, _BitTy bit, const BitFragment* frags, std::size_t n)
+{
+    uint8_t* out = (uint8_t*)(buf) + ADDR(bit);
+    uint64_t total = 0;
+
+    /* start with the untouched leading bits of the first byte */
+    int acc_len = (int)OFFSET(bit);
+    uint64_t acc = (acc_len != 0) ? ((uint64_t)BYTE_8(out, 0) >> (8 - acc_len)) : 0;
+
+    for (std::size_t f = 0; f < n; ++f)
+    {
+        const uint8_t* src = (const uint8_t*)frags[f].buf;
+        uint64_t src_bit = frags[f].bit;
+        uint64_t rem_len = frags[f].len;
+        const uint8_t* end = src + ADDR(src_bit + rem_len + 7);
+        total += rem_len;
+
+        while (rem_len > 0)
+        {
+            const uint8_t* in = src + ADDR(src_bit);
+            const int width = (rem_len < 56) ? (int)rem_len : 56;
+
+            uint64_t word;
+            if (end - in >= 8)
+            {
+                word = BYTE_64_LOAD(in, 0);
+            }
+            else
+            {
+                uint8_t tail[8] = { 0 };
+                (void)memcpy(tail, in, (std::size_t)(end - in));
+                word = BYTE_64_LOAD(tail, 0);
+            }
+
+            uint64_t val = (word << OFFSET(src_bit)) >> (64 - width);
+            src_bit += width;
+            rem_len -= width;
+
+            if (acc_len + width <= 64)
+            {
+                acc = (acc << width) | val;
+                acc_len += width;
+            }
+            else
+            {
+                int head_len = 64 - acc_len;
+                BYTE_64_STORE(out, 0, (acc << head_len) | (val >> (width - head_len)));
+                out += 8;
+                acc = val & MASK64(width - head_len);
+                acc_len = width - head_len;
+            }
+
+            if (acc_len == 64)
+            {
+                BYTE_64_STORE(out, 0, acc);
+                out += 8;
+                acc = 0;
+                acc_len = 0;
+            }
+        }
+    }
+
+    if (acc_len > 0)
+        BIT_WBITS(out, 0, acc_len, acc);
+
+    return (uint64_t)bit + total;
+}
+
 #endif /* __BIT_BITS_H__ */
@@ -2,25 +2,145 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "bit_bits.h"
+#include "bit_constexpr.h"
+#include "bit_coroutine.h"
+#include "bit_crc.h"
+#include "bit_diff.h"
+#include "bit_extract.h"
+#include "bit_gather.h"
+#include "bit_hdlc.h"
+#include "bit_morton.h"
+#include "bit_multi.h"
+#include "bit_parallel.h"
+#include "bit_pattern.h"
+#include "bit_reverse.h"
+#include "bit_rice.h"
+#include "bit_rle.h"
+#include "bit_scan.h"
+#include "bit_schema.h"
+#include "bit_stats.h"
+#include "bit_transpose.h"
+#include "bit_atomic.h"
+#include "elias_fano.h"
+#include "packed_array.h"
+
+// random numbers of the tests: a splitmix64 generator per thread, seeded for
+// every repetition, so that a repetition only depends on its seed
+static thread_local uint64_t test_rng_state = 0;
+
+static uint64_t test_mix(uint64_t x)
+{
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	return x ^ (x >> 31);
+}
+
+static void test_seed(uint64_t seed)
+{
+	test_rng_state = seed;
+}
+
+static uint64_t rand64()
+{
+	test_rng_state += 0x9E3779B97F4A7C15ULL;
+	return test_mix(test_rng_state);
+}
+
+static int test_rand()
+{
+	return (int)(rand64() >> 33);
+}
 
 static void fill_byte_and_bits(uint8_t& byte, uint8_t* bits)
 {
-	bits[0] = (std::rand() & 0x01);
-	bits[1] = (std::rand() & 0x01);
-	bits[2] = (std::rand() & 0x01);
-	bits[3] = (std::rand() & 0x01);
-	bits[4] = (std::rand() & 0x01);
-	bits[5] = (std::rand() & 0x01);
-	bits[6] = (std::rand() & 0x01);
-	bits[7] = (std::rand() & 0x01);
+	bits[0] = (test_rand() & 0x01);
+	bits[1] = (test_rand() & 0x01);
+	bits[2] = (test_rand() & 0x01);
+	bits[3] = (test_rand() & 0x01);
+	bits[4] = (test_rand() & 0x01);
+	bits[5] = (test_rand() & 0x01);
+	bits[6] = (test_rand() & 0x01);
+	bits[7] = (test_rand() & 0x01);
 
 	byte = (bits[0] << 7) | (bits[1] << 6) | (bits[2] << 5) | (bits[3] << 4) |
 		(bits[4] << 3) | (bits[5] << 2) | (bits[6] << 1) | bits[7];
 }
 
+// the test runner: the base seed and the number of threads of the run; with a
+// seed on the command line a single repetition of every test runs with it
+static uint64_t test_base_seed = 0;
+static bool test_single_seed = false;
+static int test_thread_count = 1;
+
+// seed of repetition 'rep' of the run
+static uint64_t test_rep_seed(int rep)
+{
+	return test_single_seed ? test_base_seed : test_mix(test_base_seed + (uint64_t)rep);
+}
+
+// run 'reps' repetitions of a test on 'test_thread_count' threads (or on one
+//     thread if not 'parallel'); every repetition seeds the generator of its
+//     thread, fills random buffers of 'byte_count' bytes (byte_array, the bits
+//     of it in bit_array and a scratch test_array) and runs 'test'. on a
+//     failure the seed of the failed repetition is printed
+static bool test_launcher(const char* name, int reps, int byte_count,
+	const std::function<bool(const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array)>& test, bool parallel = true)
+{
+	using namespace std::chrono;
+
+	printf("#\n%s: \n#\n", name);
+	auto t0 = steady_clock::now();
+
+	if (test_single_seed)
+		reps = 1;
+
+	std::atomic<int> next_rep(0);
+	std::atomic<bool> failed(false);
+	std::mutex failed_lock;
+	int failed_rep = reps;
+
+	auto worker = [&]() {
+		std::vector<uint8_t> bit_array((std::size_t)byte_count * 8 + 1), byte_array((std::size_t)byte_count + 1), test_array((std::size_t)byte_count + 1);
+		for (int rep = next_rep++; rep < reps && !failed; rep = next_rep++)
+		{
+			test_seed(test_rep_seed(rep));
+			for (int i = 0; i < byte_count; ++i)
+				fill_byte_and_bits(byte_array[i], bit_array.data() + 8 * i);
+
+			if (test(bit_array.data(), byte_array.data(), test_array.data()) == false)
+			{
+				std::lock_guard<std::mutex> guard(failed_lock);
+				if (rep < failed_rep)
+					failed_rep = rep;
+				failed = true;
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int t = 1; parallel && t < test_thread_count; ++t)
+		threads.emplace_back(worker);
+	worker();
+	for (std::thread& thread : threads)
+		thread.join();
+
+	if (failed)
+		printf("test failed! (seed 0x%016llx) \n", (unsigned long long)test_rep_seed(failed_rep));
+
+	printf("Ellapsed Time: %.2f sec \n", duration_cast<duration<double>>(steady_clock::now() - t0).count());
+	return !failed;
+}
+
 static bool bit_bits_test(const uint8_t* bit_array, const int bit_count, const uint8_t* byte_array, const int byte_count)
 {
 	// BIT_FLAG(buf,bit)
@@ -231,9 +351,9 @@ static bool bit_bits_test(const uint8_t* bit_array, const int bit_count, const u
 		{
 			int bit_field_len;
 			if (bit_count - bit_index >= 64)
-				bit_field_len = 1 + (std::rand() & 0x3f); /* 1 - 64 */
+				bit_field_len = 1 + (test_rand() & 0x3f); /* 1 - 64 */
 			else
-				bit_field_len = 1 + (std::rand() % (bit_count - bit_index)); /* 1 - (bit_count - bit_index) */
+				bit_field_len = 1 + (test_rand() % (bit_count - bit_index)); /* 1 - (bit_count - bit_index) */
 
 			uint64_t result{};
 			BIT_BITS_INC(byte_array_local, bit_index_local, bit_field_len, result);
@@ -261,7 +381,7 @@ static bool bit_bits_test(const uint8_t* bit_array, const int bit_count, const u
 				if (bit_index + bit_field_len > bit_count)
 					continue;
 
-				int dest_bit_index = (std::rand() & 0x07);
+				int dest_bit_index = (test_rand() & 0x07);
 
 				memset(result_array, 0x55, 25);
 				BIT_BITS_BUFFER(byte_array, bit_index, bit_field_len, result_array, dest_bit_index);
@@ -291,11 +411,11 @@ static bool bit_bits_test(const uint8_t* bit_array, const int bit_count, const u
 		{
 			int bit_field_len;
 			if (remained_bits >= 191)
-				bit_field_len = 65 + (std::rand() % (191 - 65 + 1)); /* 65 - 191 */
+				bit_field_len = 65 + (test_rand() % (191 - 65 + 1)); /* 65 - 191 */
 			else if (remained_bits >= 65)
-				bit_field_len = 65 + (std::rand() % (remained_bits - 65 + 1)) /* 65 - remained_bits */;
+				bit_field_len = 65 + (test_rand() % (remained_bits - 65 + 1)) /* 65 - remained_bits */;
 			else
-				bit_field_len = 1 + (std::rand() % remained_bits); /* 1 - remained_bits */
+				bit_field_len = 1 + (test_rand() % remained_bits); /* 1 - remained_bits */
 
 			BIT_BITS_BUFFER_INC(byte_array_iterator, bit_index, bit_field_len, result_array_iterator, bit_index);
 			result_array_iterator = result_array + (byte_array_iterator - byte_array);
@@ -316,44 +436,9 @@ static bool bit_bits_test_launcher()
 	const int byte_count = 100;
 	const int bit_count = (byte_count << 3);
 
-	uint8_t* byte_array = new uint8_t[byte_count];
-	uint8_t* bit_array = new uint8_t[bit_count];
-
-	bool ret = true;
-
-	{
-		using namespace std::chrono;
-
-		printf("#\nbit_bits_test: \n#\n");
-		auto t0 = steady_clock::now();
-		auto t1 = t0;
-		for (int rep = 0; rep < 10'000; ++rep)
-		{
-			for (int i = 0; i < byte_count; ++i)
-				fill_byte_and_bits(byte_array[i], bit_array + 8 * i);
-
-			if (bit_bits_test(bit_array, bit_count, byte_array, byte_count) == false)
-			{
-				printf("test failed! \n");
-				ret = false;
-				break;
-			}
-
-			auto t2 = steady_clock::now();
-			if (duration_cast<milliseconds>(t2 - t1).count() > 600)
-			{
-				printf("%5.2f %% \n", ((double)rep * 100) / 10'000);
-				t1 = t2;
-			}
-		}
-
-		printf("Ellapsed Time: %.2f sec \n", duration_cast<duration<double>>(steady_clock::now() - t0).count());
-	}
-
-	delete[] byte_array;
-	delete[] bit_array;
-
-	return ret;
+	return test_launcher("bit_bits_test", 10'000, byte_count, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return bit_bits_test(bit_array, bit_count, byte_array, byte_count);
+	});
 }
 
 static bool bit_wbits_test(const uint8_t* bit_array, const int bit_count, const uint8_t* byte_array, const int byte_count, uint8_t* test_array)
@@ -635,9 +720,9 @@ static bool bit_wbits_test(const uint8_t* bit_array, const int bit_count, const
 		{
 			int bit_field_len;
 			if (bit_count - bit_index >= 64)
-				bit_field_len = 1 + (std::rand() & 0x3f); /* 1 - 64 */
+				bit_field_len = 1 + (test_rand() & 0x3f); /* 1 - 64 */
 			else
-				bit_field_len = 1 + (std::rand() % (bit_count - bit_index)); /* 1 - (bit_count - bit_index) */
+				bit_field_len = 1 + (test_rand() % (bit_count - bit_index)); /* 1 - (bit_count - bit_index) */
 
 			uint64_t value = bit_array[bit_index] & 0x01;
 			for (int cnt = bit_index + 1; cnt < bit_index + bit_field_len; ++cnt)
@@ -664,7 +749,7 @@ static bool bit_wbits_test(const uint8_t* bit_array, const int bit_count, const
 				if (bit_index + bit_field_len > bit_count)
 					continue;
 
-				int dest_bit_index = (std::rand() & 0x07);
+				int dest_bit_index = (test_rand() & 0x07);
 
 				memset(result_array, 0x55, 25);
 				BIT_WBITS_BUFFER(result_array, dest_bit_index, bit_field_len, byte_array, bit_index);
@@ -691,11 +776,11 @@ static bool bit_wbits_test(const uint8_t* bit_array, const int bit_count, const
 		{
 			int bit_field_len;
 			if (remained_bits >= 191)
-				bit_field_len = 65 + (std::rand() % (191 - 65 + 1)); /* 65 - 191 */
+				bit_field_len = 65 + (test_rand() % (191 - 65 + 1)); /* 65 - 191 */
 			else if (remained_bits >= 65)
-				bit_field_len = 65 + (std::rand() % (remained_bits - 65 + 1)) /* 65 - remained_bits */;
+				bit_field_len = 65 + (test_rand() % (remained_bits - 65 + 1)) /* 65 - remained_bits */;
 			else
-				bit_field_len = 1 + (std::rand() % remained_bits); /* 1 - remained_bits */
+				bit_field_len = 1 + (test_rand() % remained_bits); /* 1 - remained_bits */
 
 			BIT_WBITS_BUFFER_INC(write_array_iterator, bit_index, bit_field_len, byte_array_iterator, bit_index);
 			byte_array_iterator = (uint8_t*)byte_array + (write_array_iterator - test_array);
@@ -714,54 +799,2064 @@ static bool bit_wbits_test_launcher()
 	const int byte_count = 1010;
 	const int bit_count = (byte_count << 3);
 
-	uint8_t* bit_array = new uint8_t[bit_count];
+	return test_launcher("bit_wbits_test", 20'000, byte_count, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return bit_wbits_test(bit_array, bit_count, byte_array, byte_count, test_array);
+	});
+}
+
+static bool bit_wbits_zero_test(const uint8_t* byte_array, const int byte_count, uint8_t* test_array)
+{
+	const int bit_count = (byte_count << 3);
+
+	// BIT_WBITS_ZERO(buf,bit,len,val), the values carry garbage above 'len'
+	memset(test_array, 0, byte_count);
+	for (int bit_index = 0; bit_index < bit_count; /*_*/)
+	{
+		int bit_field_len = 1 + (test_rand() & 0x3f);
+		if (bit_field_len > bit_count - bit_index)
+			bit_field_len = bit_count - bit_index;
+
+		uint64_t value;
+		BIT_BITS(byte_array, bit_index, bit_field_len, value);
+		BIT_WBITS_ZERO(test_array, bit_index, bit_field_len, value | (rand64() & ~MASK64(bit_field_len)));
+		bit_index += bit_field_len;
+	}
+
+	if (memcmp(test_array, byte_array, byte_count) != 0)
+		return false;
+
+	// BIT_WBITS_ZERO_INC(buf,bit,len,val)
+	{
+		memset(test_array, 0, byte_count);
+		uint8_t* test_array_iterator = test_array;
+		for (int bit_index = 0, bit_index_local = 0; bit_index < bit_count; /*_*/)
+		{
+			int bit_field_len = 1 + (test_rand() & 0x3f);
+			if (bit_field_len > bit_count - bit_index)
+				bit_field_len = bit_count - bit_index;
+
+			uint64_t value;
+			BIT_BITS(byte_array, bit_index, bit_field_len, value);
+			BIT_WBITS_ZERO_INC(test_array_iterator, bit_index_local, bit_field_len, value);
+			bit_index += bit_field_len;
+		}
+
+		if (memcmp(test_array, byte_array, byte_count) != 0)
+			return false;
+	}
+
+	// BIT_WBITS_BUFFER_ZERO_INC(buf,bit,len,src,src_bit)
+	{
+		memset(test_array, 0, byte_count);
+		uint8_t* test_array_iterator = test_array;
+		for (int bit_index = 0, bit_index_local = 0; bit_index < bit_count; /*_*/)
+		{
+			int bit_field_len = 1 + test_rand() % 300;
+			if (bit_field_len > bit_count - bit_index)
+				bit_field_len = bit_count - bit_index;
+
+			BIT_WBITS_BUFFER_ZERO_INC(test_array_iterator, bit_index_local, bit_field_len, byte_array, bit_index);
+			bit_index += bit_field_len;
+		}
+
+		if (memcmp(test_array, byte_array, byte_count) != 0)
+			return false;
+	}
+
+	// BIT_BITS_BUFFER_ZERO_INC(buf,bit,len,dst,dst_bit)
+	{
+		memset(test_array, 0, byte_count);
+		const uint8_t* byte_array_iterator = byte_array;
+		for (int bit_index = 0, bit_index_local = 0; bit_index < bit_count; /*_*/)
+		{
+			int bit_field_len = 1 + test_rand() % 300;
+			if (bit_field_len > bit_count - bit_index)
+				bit_field_len = bit_count - bit_index;
+
+			BIT_BITS_BUFFER_ZERO_INC(byte_array_iterator, bit_index_local, bit_field_len, test_array, bit_index);
+			bit_index += bit_field_len;
+		}
+
+		if (memcmp(test_array, byte_array, byte_count) != 0)
+			return false;
+	}
+
+	return true;
+}
+
+static bool bit_wbits_zero_test_launcher()
+{
+	const int byte_count = 1010;
+
+	return test_launcher("bit_wbits_zero_test", 2'000, byte_count, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return bit_wbits_zero_test(byte_array, byte_count, test_array);
+	});
+}
+
+static bool packed_array_test(const uint8_t* bit_array, const int bit_count, const uint8_t* byte_array, const int byte_count)
+{
+	// BIT_BITS_PADDED(buf,bit,len,ret)
+	for (int bit_index = 0; bit_index < bit_count; ++bit_index)
+	{
+		for (int bit_field_len = 1; bit_field_len <= BIT_PADDED_MAX_LEN; ++bit_field_len)
+		{
+			if (bit_index + bit_field_len > bit_count - (BYTE_PADDING << 3))
+				continue;
+
+			uint64_t result, desired;
+			BIT_BITS_PADDED(byte_array, bit_index, bit_field_len, result);
+			BIT_BITS(byte_array, bit_index, bit_field_len, desired);
+
+			if (result != desired)
+				return false;
+		}
+	}
+
+	// BIT_WBITS_PADDED(buf,bit,len,val)
+	{
+		uint8_t* test_array = new uint8_t[byte_count];
+		memset(test_array, 0x55, byte_count);
+
+		int bit_index = 0;
+		while (bit_index < bit_count - (BYTE_PADDING << 3))
+		{
+			int bit_field_len = 1 + (test_rand() % BIT_PADDED_MAX_LEN);
+			uint64_t value;
+			BIT_BITS(byte_array, bit_index, bit_field_len, value);
+			BIT_WBITS_PADDED(test_array, bit_index, bit_field_len, value | ~MASK64(bit_field_len));
+			bit_index += bit_field_len;
+		}
+
+		bool ok = (memcmp(test_array, byte_array, ADDR(bit_index)) == 0);
+		delete[] test_array;
+		if (!ok)
+			return false;
+	}
+
+	// bit_pack(buf,bit,len,src,n) and bit_unpack(buf,bit,len,dst,n)
+	for (int bit_field_len = 1; bit_field_len <= 64; ++bit_field_len)
+	{
+		int bit_index = (test_rand() & 0x3f);
+		int n = (bit_count - bit_index) / bit_field_len;
+
+		uint64_t* values = new uint64_t[n];
+		uint64_t* result = new uint64_t[n];
+		for (int i = 0; i < n; ++i)
+			BIT_BITS(byte_array, bit_index + i * bit_field_len, bit_field_len, values[i]);
+
+		bit_unpack(byte_array, bit_index, bit_field_len, result, n);
+		bool ok = (memcmp(values, result, n * sizeof(uint64_t)) == 0);
+
+		uint8_t* test_array = new uint8_t[byte_count];
+		memcpy(test_array, byte_array, byte_count);
+		for (int i = 0; i < n; ++i)
+			BIT_WBITS(test_array, bit_index + i * bit_field_len, bit_field_len, ~values[i]);
+		for (int i = 0; i < n; ++i)
+			result[i] = values[i] | ~MASK64(bit_field_len);
+		bit_pack(test_array, bit_index, bit_field_len, result, n);
+		ok = ok && (memcmp(test_array, byte_array, byte_count) == 0);
+
+		delete[] values;
+		delete[] result;
+		delete[] test_array;
+		if (!ok)
+			return false;
+	}
+
+	// PackedArray<_Width>
+	{
+		const int n = 1000;
+		PackedArray<13> fixed(n);
+		PackedArray<> runtime(n, 1 + (test_rand() & 0x3f));
+		std::vector<uint64_t> fixed_desired(n), runtime_desired(n);
+
+		for (int i = 0; i < 4 * n; ++i)
+		{
+			int idx = test_rand() % n;
+			uint64_t value = ((uint64_t)test_rand() << 40) ^ ((uint64_t)test_rand() << 20) ^ test_rand();
+
+			fixed[idx] = value;
+			fixed_desired[idx] = value & fixed.max_value();
+			runtime.set(idx, value);
+			runtime_desired[idx] = value & runtime.max_value();
+		}
+
+		for (int i = 0; i < n; ++i)
+		{
+			if (fixed[i] != fixed_desired[i] || runtime.get(i) != runtime_desired[i])
+				return false;
+
+			if (bit_bits<uint64_t>(runtime.data(), (uint64_t)i * runtime.width(), runtime.width()) != runtime_desired[i])
+				return false;
+		}
+
+		if (!std::equal(fixed.begin(), fixed.end(), fixed_desired.begin()))
+			return false;
+
+		std::vector<uint64_t> copy(n);
+		runtime.copy_to(copy.data());
+		if (copy != runtime_desired)
+			return false;
+
+		PackedArray<> assigned(0, runtime.width());
+		assigned.assign(runtime_desired.data(), n);
+		if (memcmp(assigned.data(), runtime.data(), runtime.byte_size()) != 0)
+			return false;
+
+		runtime.resize(n / 3);
+		runtime.fill(runtime_desired[0]);
+		for (uint64_t value : runtime)
+			if (value != runtime_desired[0])
+				return false;
+
+		runtime.resize(n);
+		for (int i = n / 3; i < n; ++i)
+			if (runtime[i] != 0)
+				return false;
+	}
+
+	return true;
+}
+
+static bool packed_array_test_launcher()
+{
+	const int byte_count = 200;
+	const int bit_count = (byte_count << 3);
+
+	return test_launcher("packed_array_test", 2'000, byte_count, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return packed_array_test(bit_array, bit_count, byte_array, byte_count);
+	});
+}
+
+static bool bit_atomic_test(const uint8_t* byte_array, const int byte_count, uint64_t* test_words, int thread_count, int field_len_max, double& field_ns)
+{
+	const int bit_count = (byte_count << 3);
+
+	// cut the buffer into fields, dealt round-robin to the threads
+	std::vector<int> field_bits, field_lens;
+	std::vector<uint64_t> field_values;
+	for (int bit_index = 0; bit_index < bit_count; /*_*/)
+	{
+		int bit_field_len = 1 + (test_rand() % field_len_max);
+		if (bit_field_len > bit_count - bit_index)
+			bit_field_len = bit_count - bit_index;
+
+		uint64_t value;
+		BIT_BITS(byte_array, bit_index, bit_field_len, value);
+		field_bits.push_back(bit_index);
+		field_lens.push_back(bit_field_len);
+		field_values.push_back(value);
+		bit_index += bit_field_len;
+	}
+
+	// BIT_WBITS_ATOMIC(buf,bit,len,val) and BIT_WFLAG_ATOMIC(buf,bit,val)
+	memset(test_words, 0x55, byte_count);
+	auto writer = [&](int thread_index) {
+		for (std::size_t i = thread_index; i < field_bits.size(); i += thread_count)
+		{
+			if (field_lens[i] == 1)
+				BIT_WFLAG_ATOMIC(test_words, field_bits[i], field_values[i]);
+			else
+				BIT_WBITS_ATOMIC(test_words, field_bits[i], field_lens[i], field_values[i] | ~MASK64(field_lens[i]));
+		}
+	};
+
+	auto t0 = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for (int thread_index = 1; thread_index < thread_count; ++thread_index)
+		threads.emplace_back(writer, thread_index);
+	writer(0);
+	for (std::thread& thread : threads)
+		thread.join();
+	auto t1 = std::chrono::steady_clock::now();
+
+	field_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / field_bits.size();
+	return memcmp(test_words, byte_array, byte_count) == 0;
+}
+
+static bool bit_atomic_test_launcher()
+{
+	const int byte_count = 1 << 16;
+	const int bit_count = (byte_count << 3);
+
 	uint8_t* byte_array = new uint8_t[byte_count];
-	uint8_t* test_array = new uint8_t[byte_count];
+	uint8_t* bit_array = new uint8_t[bit_count];
+	uint64_t* test_words = new uint64_t[byte_count >> 3];
+
+	// at least 4 threads, to check the concurrent writes on small machines too
+	int max_threads = (int)std::thread::hardware_concurrency();
+	if (max_threads < 4)
+		max_threads = 4;
 
 	bool ret = true;
 
 	{
 		using namespace std::chrono;
-		printf("#\nbit_wbits_test: \n#\n");
 
+		printf("#\nbit_atomic_test: \n#\n");
 		auto t0 = steady_clock::now();
-		auto t1 = t0;
-		for (int rep = 0; rep < 20'000; ++rep)
+		// runs sequentially, as the test measures the scaling of its own threads
+		int seed_rep = 0;
+		for (int field_len_max = 4; field_len_max <= 64 && ret; field_len_max <<= 2)
 		{
-			for (int i = 0; i < byte_count; ++i)
-				fill_byte_and_bits(byte_array[i], bit_array + i * 8);
-
-			if (bit_wbits_test(bit_array, bit_count, byte_array, byte_count, test_array) == false)
-			{
-				printf("test failed! \n");
-				ret = false;
-				break;
-			}
-
-			auto t2 = steady_clock::now();
-			if (duration_cast<milliseconds>(t2 - t1).count() > 600)
+			for (int thread_count = 1; thread_count <= max_threads && ret; thread_count <<= 1)
 			{
-				printf("%5.2f %% \n", ((double)rep * 100) / 20'000);
-				t1 = t2;
+				double field_ns = 0, best_ns = 1e30;
+				for (int rep = 0; rep < (test_single_seed ? 1 : 20); ++rep)
+				{
+					uint64_t seed = test_rep_seed(seed_rep++);
+					test_seed(seed);
+					for (int i = 0; i < byte_count; ++i)
+						fill_byte_and_bits(byte_array[i], bit_array + 8 * i);
+
+					if (bit_atomic_test(byte_array, byte_count, test_words, thread_count, field_len_max, field_ns) == false)
+					{
+						printf("test failed! (seed 0x%016llx) \n", (unsigned long long)seed);
+						ret = false;
+						break;
+					}
+
+					if (field_ns < best_ns)
+						best_ns = field_ns;
+				}
+
+				printf("fields of 1 - %2d bits, %2d threads: %6.2f ns/field \n", field_len_max, thread_count, best_ns);
 			}
 		}
 
 		printf("Ellapsed Time: %.2f sec \n", duration_cast<duration<double>>(steady_clock::now() - t0).count());
 	}
 
-	delete[] bit_array;
 	delete[] byte_array;
-	delete[] test_array;
+	delete[] bit_array;
+	delete[] test_words;
+
+	return ret;
+}
+
+static bool gather_bits_test(const uint8_t* byte_array, const int byte_count)
+{
+	const int bit_count = ((byte_count - BYTE_PADDING) << 3);
+	const int field_count = 1000;
+
+	uint32_t* bit_offsets = new uint32_t[field_count];
+	uint8_t* lens = new uint8_t[field_count];
+	uint64_t* desired = new uint64_t[field_count];
+	uint64_t* result = new uint64_t[field_count];
+
+	for (int i = 0; i < field_count; ++i)
+	{
+		lens[i] = (uint8_t)(1 + (test_rand() & 0x3f));
+		bit_offsets[i] = (uint32_t)(test_rand() % (bit_count - lens[i] + 1));
+		BIT_BITS(byte_array, bit_offsets[i], lens[i], desired[i]);
+	}
+
+	bool ret = true;
+
+	// gather_bits(buf,bit_offsets,lens,n,out)
+	int n = 1 + test_rand() % field_count;
+	memset(result, 0, field_count * sizeof(uint64_t));
+	gather_bits(byte_array, bit_offsets, lens, n, result);
+	if (memcmp(result, desired, n * sizeof(uint64_t)) != 0)
+		ret = false;
+
+	// gather_bits(buf,plan,out)
+	BitGatherPlan plan(bit_offsets, lens, field_count);
+	memset(result, 0, field_count * sizeof(uint64_t));
+	gather_bits(byte_array, plan, result);
+	if (memcmp(result, desired, field_count * sizeof(uint64_t)) != 0)
+		ret = false;
+
+	delete[] bit_offsets;
+	delete[] lens;
+	delete[] desired;
+	delete[] result;
 
 	return ret;
 }
 
-int main()
+static bool gather_bits_test_launcher()
+{
+	const int byte_count = 200;
+
+	return test_launcher("gather_bits_test", 2'000, byte_count, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return gather_bits_test(byte_array, byte_count);
+	});
+}
+
+static bool bits_extract_test(const uint8_t* byte_array, const int byte_count, uint8_t* test_array)
+{
+	const int bit_count = (byte_count << 3);
+
+	for (int rep = 0; rep < 1000; ++rep)
+	{
+		int bit_field_len = 1 + (test_rand() & 0x3f);
+		int bit_index = test_rand() % (bit_count - bit_field_len + 1);
+		uint64_t mask = rand64() & MASK64(bit_field_len);
+		if (test_rand() & 1)
+			mask &= rand64();
+
+		uint64_t field;
+		BIT_BITS(byte_array, bit_index, bit_field_len, field);
+
+		// bits_extract(buf,bit,len,mask)
+		uint64_t desired = 0;
+		for (int b = 0, cnt = 0; b < 64; ++b)
+			if ((mask >> b) & 1)
+				desired |= ((field >> b) & 1) << (cnt++);
+
+		if (bits_extract(byte_array, bit_index, bit_field_len, mask) != desired)
+			return false;
+
+		// bits_deposit(buf,bit,len,mask,val)
+		uint64_t value = rand64();
+		uint64_t desired_field = field;
+		for (int b = 0, cnt = 0; b < 64; ++b)
+			if ((mask >> b) & 1)
+				desired_field = (desired_field & ~((uint64_t)1 << b)) | (((value >> (cnt++)) & 1) << b);
+
+		memcpy(test_array, byte_array, byte_count);
+		bits_deposit(test_array, bit_index, bit_field_len, mask, value);
+		uint64_t result;
+		BIT_BITS(test_array, bit_index, bit_field_len, result);
+		if (result != desired_field)
+			return false;
+
+		BIT_WBITS(test_array, bit_index, bit_field_len, field);
+		if (memcmp(test_array, byte_array, byte_count) != 0)
+			return false;
+	}
+
+	// bits_split(buf,bit,lens,k,out)
+	for (int rep = 0; rep < 1000; ++rep)
+	{
+		// every field is written, also if all lengths are 0 (rep 0)
+		uint8_t lens[8];
+		uint64_t out[8];
+		int total = 0;
+		for (int i = 0; i < 8; ++i)
+		{
+			out[i] = ~0ULL;
+			lens[i] = (rep == 0) ? 0 : (uint8_t)(test_rand() % 9);
+			total += lens[i];
+		}
+
+		int bit_index = test_rand() % (bit_count - total + 1);
+		bits_split(byte_array, bit_index, lens, out);
+		for (int i = 0, b = bit_index; i < 8; b += lens[i++])
+		{
+			uint64_t desired = 0;
+			if (lens[i] != 0)
+				BIT_BITS(byte_array, b, lens[i], desired);
+			if (out[i] != desired)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+static bool bits_extract_test_launcher()
+{
+	const int byte_count = 100;
+
+	return test_launcher("bits_extract_test", 200, byte_count, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return bits_extract_test(byte_array, byte_count, test_array);
+	});
+}
+
+static bool bit_reverse_test(const uint8_t* bit_array, const int bit_count, const uint8_t* byte_array, const int byte_count, uint8_t* test_array)
 {
-	bit_bits_test_launcher();
-	bit_wbits_test_launcher();
+	// bit_reverse_bytes(dst,src,len)
+	{
+		int off = test_rand() & 0x0f;
+		int len = test_rand() % (byte_count - off + 1);
+
+		memset(test_array, 0x55, byte_count);
+		bit_reverse_bytes(test_array + off, byte_array + off, len);
+		for (int i = 0; i < byte_count; ++i)
+		{
+			uint8_t desired = 0x55;
+			if (i >= off && i < off + len)
+			{
+				desired = 0;
+				for (int b = 0; b < 8; ++b)
+					desired |= (bit_array[8 * i + b] << b);
+			}
+
+			if (test_array[i] != desired)
+				return false;
+		}
+
+		bit_reverse_bytes(test_array + off, test_array + off, len);
+		if (memcmp(test_array + off, byte_array + off, len) != 0)
+			return false;
+	}
+
+	// byte_swap16_buffer, byte_swap32_buffer, byte_swap64_buffer(dst,src,cnt)
+	{
+		int cnt = test_rand() % (byte_count / 8 + 1);
+
+		memcpy(test_array, byte_array, byte_count);
+		byte_swap16_buffer(test_array, test_array, cnt * 4);
+		for (int i = 0; i < cnt * 4; ++i)
+			if (BYTE_16LE(test_array, 2 * i) != BYTE_16(byte_array, 2 * i))
+				return false;
+
+		byte_swap32_buffer(test_array, byte_array, cnt * 2);
+		for (int i = 0; i < cnt * 2; ++i)
+			if (BYTE_32LE(test_array, 4 * i) != BYTE_32(byte_array, 4 * i))
+				return false;
 
-	printf("\npress any key to continue ");
-	(void)getchar();
-	return 0;
+		byte_swap64_buffer(test_array, byte_array, cnt);
+		for (int i = 0; i < cnt; ++i)
+			if (BYTE_64LE(test_array, 8 * i) != BYTE_64(byte_array, 8 * i))
+				return false;
+	}
+
+	// bit_reverse_range(buf,bit,len)
+	for (int rep = 0; rep < 20; ++rep)
+	{
+		int bit_index = test_rand() % bit_count;
+		int len = test_rand() % (bit_count - bit_index + 1);
+		if (rep == 0)
+		{
+			bit_index &= ~0x07;
+			len &= ~0x07;
+		}
+
+		memcpy(test_array, byte_array, byte_count);
+		bit_reverse_range(test_array, bit_index, len);
+		for (int b = 0; b < bit_count; ++b)
+		{
+			int src = (b >= bit_index && b < bit_index + len) ? (2 * bit_index + len - 1 - b) : b;
+			if (BIT_FLAG(test_array, b) != bit_array[src])
+				return false;
+		}
+	}
+
+	return true;
+}
+
+static bool bit_reverse_test_launcher()
+{
+	const int byte_count = 300;
+	const int bit_count = (byte_count << 3);
+
+	return test_launcher("bit_reverse_test", 1'000, byte_count, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return bit_reverse_test(bit_array, bit_count, byte_array, byte_count, test_array);
+	});
+}
+
+static bool bit_transpose_test(const uint8_t* bit_array, const int bit_count, const uint8_t* byte_array, const int byte_count)
+{
+	// bit_transpose8x8(val) and bit_transpose8x8_x8(mat)
+	{
+		uint64_t mat[8];
+		for (int i = 0; i < 8; ++i)
+			mat[i] = BYTE_64(byte_array, 8 * i);
+
+		bit_transpose8x8_x8(mat);
+		for (int i = 0; i < 8; ++i)
+		{
+			if (bit_transpose8x8(BYTE_64(byte_array, 8 * i)) != mat[i])
+				return false;
+
+			for (int r = 0; r < 8; ++r)
+				for (int c = 0; c < 8; ++c)
+					if (((mat[i] >> (63 - (8 * c + r))) & 1) != bit_array[64 * i + 8 * r + c])
+						return false;
+		}
+	}
+
+	// bit_transpose16x16(rows)
+	{
+		uint16_t rows[16];
+		for (int r = 0; r < 16; ++r)
+			rows[r] = (uint16_t)BYTE_16(byte_array, 2 * r);
+
+		bit_transpose16x16(rows);
+		for (int r = 0; r < 16; ++r)
+			for (int c = 0; c < 16; ++c)
+				if (((rows[c] >> (15 - r)) & 1) != bit_array[16 * r + c])
+					return false;
+	}
+
+	// bit_transpose64x64(rows)
+	{
+		uint64_t rows[64];
+		for (int r = 0; r < 64; ++r)
+			rows[r] = BYTE_64(byte_array, 8 * r);
+
+		bit_transpose64x64(rows);
+		for (int r = 0; r < 64; ++r)
+			for (int c = 0; c < 64; ++c)
+				if (((rows[c] >> (63 - r)) & 1) != bit_array[64 * r + c])
+					return false;
+	}
+
+	// to_bitplanes(buf,bit,len,n,planes,stride) and from_bitplanes(planes,stride,len,n,buf,bit)
+	{
+		int len = 1 + (test_rand() & 0x3f);
+		int bit_index = test_rand() & 0x3f;
+		int n = test_rand() % ((bit_count - bit_index) / len + 1);
+		std::size_t stride = (n + 7) / 8 + (test_rand() & 0x03);
+
+		std::vector<uint8_t> planes(stride * len + 1, 0x55);
+		to_bitplanes(byte_array, bit_index, len, n, planes.data(), stride);
+		for (int p = 0; p < len; ++p)
+			for (int i = 0; i < n; ++i)
+				if (BIT_FLAG(planes.data() + p * stride, i) != bit_array[bit_index + i * len + p])
+					return false;
+
+		std::vector<uint8_t> test_array(byte_array, byte_array + byte_count);
+		for (int i = bit_index; i < bit_index + n * len; ++i)
+			BIT_WFLAG(test_array.data(), i, bit_array[i] ^ 1);
+
+		from_bitplanes(planes.data(), stride, len, n, test_array.data(), bit_index);
+		if (memcmp(test_array.data(), byte_array, byte_count) != 0)
+			return false;
+	}
+
+	return true;
+}
+
+static bool bit_transpose_test_launcher()
+{
+	const int byte_count = 512;
+	const int bit_count = (byte_count << 3);
+
+	return test_launcher("bit_transpose_test", 1'000, byte_count, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return bit_transpose_test(bit_array, bit_count, byte_array, byte_count);
+	});
+}
+
+static bool bit_morton_test(const uint8_t* byte_array, const int byte_count, uint8_t* test_array)
+{
+	const int bit_count = (byte_count << 3);
+	const int n = 256;
+
+	uint32_t x[n], y[n], z[n], rx[n], ry[n], rz[n];
+	uint64_t keys[n];
+
+	// morton2d_encode32_n(x,y,keys,n) and morton2d_decode32_n(keys,x,y,n)
+	for (int i = 0; i < n; ++i)
+	{
+		x[i] = (uint32_t)rand64();
+		y[i] = (uint32_t)rand64();
+	}
+
+	morton2d_encode32_n(x, y, keys, n);
+	for (int i = 0; i < n; ++i)
+	{
+		uint64_t desired = 0;
+		for (int b = 0; b < 32; ++b)
+			desired |= ((uint64_t)((x[i] >> b) & 1) << (2 * b)) | ((uint64_t)((y[i] >> b) & 1) << (2 * b + 1));
+
+		if (keys[i] != desired || morton2d_encode16((uint16_t)x[i], (uint16_t)y[i]) != (uint32_t)desired)
+			return false;
+
+		uint16_t x16, y16;
+		morton2d_decode16((uint32_t)desired, x16, y16);
+		if (x16 != (uint16_t)x[i] || y16 != (uint16_t)y[i])
+			return false;
+	}
+
+	morton2d_decode32_n(keys, rx, ry, n);
+	if (memcmp(rx, x, sizeof(x)) != 0 || memcmp(ry, y, sizeof(y)) != 0)
+		return false;
+
+	// morton3d_encode21_n(x,y,z,keys,n) and morton3d_decode21_n(keys,x,y,z,n)
+	for (int i = 0; i < n; ++i)
+	{
+		x[i] = (uint32_t)rand64() & 0x1FFFFF;
+		y[i] = (uint32_t)rand64() & 0x1FFFFF;
+		z[i] = (uint32_t)rand64() & 0x1FFFFF;
+	}
+
+	morton3d_encode21_n(x, y, z, keys, n);
+	for (int i = 0; i < n; ++i)
+	{
+		uint64_t desired = 0;
+		for (int b = 0; b < 21; ++b)
+			desired |= ((uint64_t)((x[i] >> b) & 1) << (3 * b)) | ((uint64_t)((y[i] >> b) & 1) << (3 * b + 1)) |
+				((uint64_t)((z[i] >> b) & 1) << (3 * b + 2));
+
+		if (keys[i] != desired)
+			return false;
+	}
+
+	morton3d_decode21_n(keys, rx, ry, rz, n);
+	if (memcmp(rx, x, sizeof(x)) != 0 || memcmp(ry, y, sizeof(y)) != 0 || memcmp(rz, z, sizeof(z)) != 0)
+		return false;
+
+	// bit_morton2d, bit_wmorton2d, bit_morton3d, bit_wmorton3d(buf,bit,len,...)
+	for (int rep = 0; rep < 100; ++rep)
+	{
+		int len2 = 1 + (test_rand() & 0x1f), len3 = 1 + (test_rand() % 21);
+		int bit2 = test_rand() % (bit_count - 2 * len2 + 1), bit3 = test_rand() % (bit_count - 3 * len3 + 1);
+
+		uint32_t x2, y2, x3, y3, z3;
+		bit_morton2d(byte_array, bit2, len2, x2, y2);
+		bit_morton3d(byte_array, bit3, len3, x3, y3, z3);
+
+		uint64_t key2, key3;
+		BIT_BITS(byte_array, bit2, 2 * len2, key2);
+		BIT_BITS(byte_array, bit3, 3 * len3, key3);
+		if (morton2d_encode32(x2, y2) != key2 || morton3d_encode21(x3, y3, z3) != key3)
+			return false;
+
+		memset(test_array, 0x55, byte_count);
+		bit_wmorton2d(test_array, bit2, len2, x2, y2);
+		if (bit_bits<uint64_t>(test_array, bit2, 2 * len2) != key2)
+			return false;
+
+		memcpy(test_array, byte_array, byte_count);
+		bit_wmorton3d(test_array, bit3, len3, x3 ^ 1, y3, z3);
+		bit_wmorton3d(test_array, bit3, len3, x3, y3, z3);
+		if (memcmp(test_array, byte_array, byte_count) != 0)
+			return false;
+	}
+
+	return true;
+}
+
+static bool bit_morton_test_launcher()
+{
+	const int byte_count = 100;
+
+	return test_launcher("bit_morton_test", 200, byte_count, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return bit_morton_test(byte_array, byte_count, test_array);
+	});
+}
+
+// a header template baked into the binary: 0xD3, 6 zero bits, a 10 bit length of 19
+static constexpr std::array<uint8_t, 8> bit_constexpr_template = bit_template_cx<8>({ { 0, 8, 0xD3 }, { 8, 6, 0 }, { 14, 10, 19 } });
+static_assert(bit_constexpr_template[0] == 0xD3 && bit_constexpr_template[1] == 0x00 && bit_constexpr_template[2] == 0x13, "bit_template_cx");
+static_assert(bit_bits_cx(bit_constexpr_template, 14, 10) == 19, "bit_bits_cx");
+static_assert(bit_flag_cx(bit_constexpr_template, 1) == 1 && bit_flag_cx(bit_constexpr_template, 2) == 0, "bit_flag_cx");
+static_assert(byte_bytes_cx(bit_constexpr_template, 0, 3) == 0xD30013, "byte_bytes_cx");
+static_assert(byte_bytes_le_cx(bit_constexpr_template, 0, 3) == 0x1300D3, "byte_bytes_le_cx");
+static_assert(byte_swap64_cx(0x0102030405060708ULL) == 0x0807060504030201ULL, "byte_swap64_cx");
+static_assert(byte_swap32_cx(0x01020304) == 0x04030201 && byte_swap16_cx(0x0102) == 0x0201, "byte_swap32_cx");
+
+static bool bit_constexpr_test(const uint8_t* byte_array)
+{
+	const int byte_count = 64;
+	const int bit_count = (byte_count << 3);
+
+	std::array<uint8_t, byte_count> buf{};
+	std::copy(byte_array, byte_array + byte_count, buf.begin());
+
+	// bit_bits_cx(buf,bit,len), bit_flag_cx(buf,bit)
+	for (int bit_index = 0; bit_index < bit_count; ++bit_index)
+	{
+		for (int bit_field_len = 1; bit_field_len <= 64; ++bit_field_len)
+		{
+			if (bit_index + bit_field_len > bit_count)
+				continue;
+
+			uint64_t desired;
+			BIT_BITS(byte_array, bit_index, bit_field_len, desired);
+			if (bit_bits_cx(buf, bit_index, bit_field_len) != desired)
+				return false;
+		}
+
+		if (bit_flag_cx(buf, bit_index) != BIT_FLAG(byte_array, bit_index))
+			return false;
+	}
+
+	// bit_wbits_cx(buf,bit,len,val), bit_wflag_cx(buf,bit,val)
+	std::array<uint8_t, byte_count> test{};
+	std::array<uint8_t, byte_count> desired{};
+	for (int bit_index = 0; bit_index < bit_count; /*_*/)
+	{
+		int bit_field_len = 1 + (test_rand() & 0x3f);
+		if (bit_field_len > bit_count - bit_index)
+			bit_field_len = bit_count - bit_index;
+
+		uint64_t value = rand64();
+		bit_wbits_cx(test, bit_index, bit_field_len, value);
+		BIT_WBITS(desired.data(), bit_index, bit_field_len, value);
+		bit_wflag_cx(test, bit_index, value >> 7);
+		BIT_WFLAG(desired.data(), bit_index, value >> 7);
+		bit_index += bit_field_len;
+	}
+
+	if (test != desired)
+		return false;
+
+	// byte_bytes_cx, byte_bytes_le_cx, byte_wbytes_cx, byte_wbytes_le_cx(buf,off,len,...)
+	for (int len = 1; len <= 8; ++len)
+	{
+		int off = test_rand() % (byte_count - len + 1);
+		uint64_t be = 0, le = 0, value = rand64();
+		BYTE_BYTES(byte_array + off, len, be);
+		BYTE_BYTES_LE(byte_array + off, len, le);
+		if (byte_bytes_cx(buf, off, len) != be || byte_bytes_le_cx(buf, off, len) != le)
+			return false;
+
+		byte_wbytes_cx(test, off, len, value);
+		BYTE_WBYTES(desired.data() + off, len, value);
+		if (test != desired)
+			return false;
+
+		byte_wbytes_le_cx(test, off, len, value);
+		BYTE_WBYTES_LE(desired.data() + off, len, value);
+		if (test != desired)
+			return false;
+	}
+
+	return true;
+}
+
+static bool bit_constexpr_test_launcher()
+{
+	const int byte_count = 64;
+
+	return test_launcher("bit_constexpr_test", 200, byte_count, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return bit_constexpr_test(byte_array);
+	});
+}
+
+static bool bit_scan_test(const uint8_t* byte_array, const int byte_count)
+{
+	const std::size_t stride = 1 + test_rand() % 24;
+	const std::size_t count = (byte_count - BYTE_PADDING) / stride;
+	const int record_bits = (int)(stride << 3);
+
+	// predicates on random bitfields of the records; the constants are taken
+	// from the first record to get a useful selectivity
+	BitPredicate preds[4];
+	const std::size_t k = test_rand() % 5;
+	for (std::size_t p = 0; p < k; ++p)
+	{
+		preds[p].len = 1 + test_rand() % (record_bits < 64 ? record_bits : 64);
+		preds[p].bit = (uint32_t)(test_rand() % (record_bits - preds[p].len + 1));
+		preds[p].op = (BitScanOp)(test_rand() % 7);
+		BIT_BITS(byte_array, preds[p].bit, preds[p].len, preds[p].val);
+		preds[p].hi = preds[p].val + (rand64() & MASK64(preds[p].len));
+		if (test_rand() & 1)
+			preds[p].val = rand64() & MASK64(preds[p].len);
+		else if (test_rand() & 1)
+			preds[p].val = (test_rand() & 1) ? 0 : ~(uint64_t)0;
+	}
+
+	BitScanCombine comb = (test_rand() & 1) ? BIT_SCAN_ANY : BIT_SCAN_ALL;
+
+	std::vector<uint64_t> desired_bitmap((count + 63) / 64, 0);
+	std::vector<uint32_t> desired_index;
+	for (std::size_t r = 0; r < count; ++r)
+	{
+		bool sel = (comb == BIT_SCAN_ALL);
+		for (std::size_t p = 0; p < k; ++p)
+		{
+			uint64_t field = 0;
+			BIT_BITS(byte_array, r * record_bits + preds[p].bit, preds[p].len, field);
+
+			bool m = false;
+			switch (preds[p].op)
+			{
+			case BIT_SCAN_EQ: m = (field == preds[p].val); break;
+			case BIT_SCAN_NE: m = (field != preds[p].val); break;
+			case BIT_SCAN_LT: m = (field < preds[p].val); break;
+			case BIT_SCAN_LE: m = (field <= preds[p].val); break;
+			case BIT_SCAN_GT: m = (field > preds[p].val); break;
+			case BIT_SCAN_GE: m = (field >= preds[p].val); break;
+			case BIT_SCAN_IN: m = (field >= preds[p].val && field <= preds[p].hi); break;
+			}
+
+			sel = (comb == BIT_SCAN_ALL) ? (sel && m) : (sel || m);
+		}
+
+		if (sel)
+		{
+			desired_bitmap[r >> 6] |= (uint64_t)1 << (r & 63);
+			desired_index.push_back((uint32_t)r);
+		}
+	}
+
+	BitScanPlan plan(preds, k, comb);
+
+	// scan_records(buf,stride,count,plan,bitmap)
+	std::vector<uint64_t> bitmap((count + 63) / 64, ~(uint64_t)0);
+	if (scan_records(byte_array, stride, count, plan, bitmap.data()) != desired_index.size() || bitmap != desired_bitmap)
+		return false;
+
+	// select_records(buf,stride,count,plan,index)
+	std::vector<uint32_t> index(count + 1, 0);
+	if (select_records(byte_array, stride, count, plan, index.data()) != desired_index.size() ||
+		!std::equal(desired_index.begin(), desired_index.end(), index.begin()))
+		return false;
+
+	return true;
+}
+
+static bool bit_scan_test_launcher()
+{
+	const int byte_count = 2000;
+
+	return test_launcher("bit_scan_test", 2'000, byte_count, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return bit_scan_test(byte_array, byte_count);
+	});
+}
+
+static bool bit_stats_test()
+{
+	const int thread_count = 4;
+	uint8_t buf[16] = { 0 };
+
+	bit_stats_reset();
+
+	// every thread reads two overlapping ranges, writes and copies
+	std::vector<std::thread> threads;
+	for (int t = 0; t < thread_count; ++t)
+	{
+		threads.emplace_back([&buf, t]() {
+			bit_stats_read(buf, 2);
+			bit_stats_read(buf + 1, 9);
+			bit_stats_write(9);
+			bit_stats_write(t + 1);
+			bit_stats_padded_read();
+			bit_stats_padded_write();
+			bit_stats_copy(100);
+			bit_stats_copy(1);
+		});
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	bit_stats_read(buf + 12, 4);
+
+	BitStats stats = bit_stats_snapshot();
+	if (stats.count[BIT_STATS_READS + 2] != thread_count || stats.count[BIT_STATS_READS + 9] != thread_count ||
+		stats.count[BIT_STATS_READS + 4] != 1 || stats.count[BIT_STATS_WRITES + 9] != thread_count ||
+		stats.count[BIT_STATS_WRITES + 1] != 1 || stats.count[BIT_STATS_WRITES + 4] != 1)
+		return false;
+
+	if (stats.count[BIT_STATS_BYTES_READ] != 11 * thread_count + 4 || stats.count[BIT_STATS_BYTES_REREAD] != thread_count ||
+		stats.count[BIT_STATS_BYTES_WRITTEN] != 9 * thread_count + (1 + 2 + 3 + 4))
+		return false;
+
+	if (stats.count[BIT_STATS_PADDED_READS] != thread_count || stats.count[BIT_STATS_PADDED_WRITES] != thread_count)
+		return false;
+
+	if (stats.count[BIT_STATS_COPIES] != 2 * thread_count || stats.count[BIT_STATS_COPY_BITS] != 101 * thread_count ||
+		stats.count[BIT_STATS_COPY_LENS + 6] != thread_count || stats.count[BIT_STATS_COPY_LENS + 0] != thread_count)
+		return false;
+
+	std::string json = bit_stats_json(stats);
+	if (json.find("\"straddle_reads\": 4,") == std::string::npos || json.find("\"copy_lens\": { \"1\": 4, ") == std::string::npos ||
+		json.find("\"64\": 4") == std::string::npos || json.find(",\n}") != std::string::npos)
+		return false;
+
+	bit_stats_reset();
+	stats = bit_stats_snapshot();
+	for (int i = 0; i < BIT_STATS_COUNT; ++i)
+		if (stats.count[i] != 0)
+			return false;
+
+	return true;
+}
+
+static bool bit_stats_test_launcher()
+{
+	// runs on a single thread, as the counters are shared by all threads
+	return test_launcher("bit_stats_test", 100, 0, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return bit_stats_test();
+	}, false);
+}
+
+// in bit_instrument_test.cpp, which is compiled with BIT_INSTRUMENT
+bool bit_instrument_test();
+
+static bool bit_instrument_test_launcher()
+{
+	// runs on a single thread, as the counters are shared by all threads
+	return test_launcher("bit_instrument_test", 100, 0, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return bit_instrument_test();
+	}, false);
+}
+
+static bool concat_bits_test(const uint8_t* byte_array, const int byte_count, uint8_t* test_array)
+{
+	const int bit_count = (byte_count << 3);
+
+	// fragments of 0 - 300 bits of byte_array, written after some leading bits
+	// of a buffer filled with garbage
+	std::vector<BitFragment> frags;
+	int dst_bit = test_rand() % 64;
+	int total = 0;
+	for (int i = 0, n = test_rand() % 40; i < n; ++i)
+	{
+		int len = test_rand() % 301;
+		if (total + len > bit_count - dst_bit)
+			break;
+
+		BitFragment frag;
+		frag.buf = byte_array;
+		frag.len = len;
+		frag.bit = test_rand() % (bit_count - len + 1);
+		frags.push_back(frag);
+		total += len;
+	}
+
+	std::vector<uint8_t> desired(byte_count);
+	for (int i = 0; i < byte_count; ++i)
+		desired[i] = test_array[i] = (uint8_t)test_rand();
+
+	for (int i = 0, bit_index = dst_bit; i < (int)frags.size(); bit_index += (int)frags[i].len, ++i)
+		BIT_WBITS_BUFFER(desired.data(), bit_index, frags[i].len, byte_array, frags[i].bit);
+
+	// concat_bits(buf,bit,frags,n)
+	if (concat_bits(test_array, dst_bit, frags.data(), frags.size()) != (uint64_t)(dst_bit + total))
+		return false;
+
+	return memcmp(test_array, desired.data(), byte_count) == 0;
+}
+
+static bool concat_bits_test_launcher()
+{
+	const int byte_count = 1010;
+
+	return test_launcher("concat_bits_test", 2'000, byte_count, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return concat_bits_test(byte_array, byte_count, test_array);
+	});
+}
+
+// reference CRC, one bit at a time: the range is fed as consecutive 8-bit
+// values followed by the remaining bits, every value MSB first, or LSB first
+// for a reflected CRC
+static uint32_t crc_reference(const uint8_t* buf, uint64_t bit, uint64_t len, int width, uint32_t poly, uint32_t init, bool reflected, uint32_t xorout)
+{
+	const uint32_t top = 1u << (width - 1);
+	const uint32_t mask = (uint32_t)MASK64(width);
+	uint32_t rpoly = 0, reg = 0;
+	for (int i = 0; i < width; ++i)
+	{
+		rpoly |= ((poly >> i) & 1) << (width - 1 - i);
+		reg |= ((init >> i) & 1) << (width - 1 - i);
+	}
+	if (!reflected)
+		reg = init;
+
+	for (; len > 0; /*_*/)
+	{
+		int g = (len < 8) ? (int)len : 8;
+		uint64_t val;
+		BIT_BITS(buf, bit, g, val);
+		for (int j = 0; j < g; ++j)
+		{
+			if (reflected)
+			{
+				uint32_t b = (uint32_t)(val >> j) & 1;
+				reg = ((reg ^ b) & 1) ? ((reg >> 1) ^ rpoly) : (reg >> 1);
+			}
+			else
+			{
+				uint32_t b = (uint32_t)(val >> (g - 1 - j)) & 1;
+				reg = (((reg & top) != 0) != (b != 0)) ? (((reg << 1) ^ poly) & mask) : ((reg << 1) & mask);
+			}
+		}
+		bit += g;
+		len -= g;
+	}
+
+	return reg ^ xorout;
+}
+
+static bool bit_crc_test(const uint8_t* byte_array, const int byte_count, uint8_t* test_array)
+{
+	const int bit_count = (byte_count << 3);
+	static const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+	static const BitCrc crc5_usb(5, 0x05, 0x1F, true, 0x1F);
+	static const BitCrc crc12(12, 0x80F, 0, false, 0);
+
+	// the check values of "123456789", at every bit offset
+	for (int off = 0; off < 8; ++off)
+	{
+		test_array[0] = (uint8_t)test_rand();
+		BIT_WBITS_BUFFER(test_array, off, 72, check, 0);
+		if (crc24q_bits(test_array, off, 72) != 0xCDE703 ||
+			crc16_ccitt_bits(test_array, off, 72) != 0x29B1 ||
+			crc32c_bits(test_array, off, 72) != 0xE3069283 ||
+			crc5_usb.compute(test_array, off, 72) != 0x19)
+			return false;
+	}
+
+	// random ranges, checked against the reference
+	for (int i = 0; i < 20; ++i)
+	{
+		uint64_t len = test_rand() % ((i < 10) ? 80 : 2000);
+		uint64_t bit = test_rand() % (bit_count - len - 64);
+
+		if (crc24q_bits(byte_array, bit, len) != crc_reference(byte_array, bit, len, 24, 0x864CFB, 0, false, 0) ||
+			crc16_ccitt_bits(byte_array, bit, len) != crc_reference(byte_array, bit, len, 16, 0x1021, 0xFFFF, false, 0) ||
+			crc32c_bits(byte_array, bit, len) != crc_reference(byte_array, bit, len, 32, 0x1EDC6F41, 0xFFFFFFFF, true, 0xFFFFFFFF) ||
+			crc5_usb.compute(byte_array, bit, len) != crc_reference(byte_array, bit, len, 5, 0x05, 0x1F, true, 0x1F) ||
+			crc12.compute(byte_array, bit, len) != crc_reference(byte_array, bit, len, 12, 0x80F, 0, false, 0))
+			return false;
+	}
+
+	return true;
+}
+
+static bool bit_crc_test_launcher()
+{
+	const int byte_count = 1010;
+
+	return test_launcher("bit_crc_test", 2'000, byte_count, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return bit_crc_test(byte_array, byte_count, test_array);
+	});
+}
+
+static bool bit_schema_test(const uint8_t* byte_array, const int byte_count)
+{
+	const int bit_count = ((byte_count - BYTE_PADDING) << 3);
+
+	// a table of up to 40 fields, some of them skipped, with the slots
+	// shuffled; decoded by the program and field by field by BIT_BITS_INC
+	std::vector<BitSchemaField> fields;
+	int total = 0;
+	for (int i = 0, n = test_rand() % 41; i < n; ++i)
+	{
+		BitSchemaField f;
+		f.type = (BitFieldType)(test_rand() % 3);
+		f.len = ((f.type == BIT_FIELD_SIGN_MAG) ? 2 : 1) + test_rand() % ((f.type == BIT_FIELD_SIGN_MAG) ? 63 : 64);
+		f.scale = (test_rand() % 2) ? 1.0 : (double)(test_rand() % 1000) / 64.0;
+		f.slot = (int)fields.size();
+		fields.push_back(f);
+		total += f.len;
+	}
+	for (int i = (int)fields.size() - 1; i > 0; --i)
+		std::swap(fields[i].slot, fields[test_rand() % (i + 1)].slot);
+	for (BitSchemaField& f : fields)
+		if (test_rand() % 5 == 0)
+			f.slot = -1;
+
+	const int batch = 4;
+	const int stride = (total + 7) / 8 + 3;
+	if (stride * (batch - 1) * 8 + total > bit_count)
+		return true;
+
+	BitSchema schema(fields.data(), fields.size());
+	if (schema.bits() != (uint64_t)total)
+		return false;
+
+	const std::size_t slots = schema.slots();
+	std::vector<double> values(slots * batch, -1.0), desired(slots * batch, -1.0);
+	std::vector<int64_t> raws(slots * batch, -1), desired_raws(slots * batch, -1);
+	for (int msg = 0; msg < batch; ++msg)
+	{
+		const uint8_t* buf = byte_array + msg * stride;
+		int bit = 0;
+		for (const BitSchemaField& f : fields)
+		{
+			uint64_t u;
+			BIT_BITS_INC(buf, bit, f.len, u);
+			if (f.slot < 0)
+				continue;
+
+			int64_t v = (int64_t)u;
+			if (f.type == BIT_FIELD_SIGNED && f.len < 64 && (u >> (f.len - 1)) != 0)
+				v = (int64_t)(u | ~MASK64(f.len));
+			if (f.type == BIT_FIELD_SIGN_MAG)
+				v = (u >> (f.len - 1)) ? -(int64_t)(u & MASK64(f.len - 1)) : (int64_t)(u & MASK64(f.len - 1));
+			desired_raws[msg * slots + f.slot] = v;
+			desired[msg * slots + f.slot] = (double)v * f.scale;
+		}
+	}
+
+	// run, run_batch
+	schema.run(byte_array, values.data());
+	schema.run(byte_array, raws.data());
+	if (!std::equal(values.begin(), values.begin() + slots, desired.begin()) ||
+		!std::equal(raws.begin(), raws.begin() + slots, desired_raws.begin()))
+		return false;
+
+	schema.run_batch(byte_array, stride, batch, values.data());
+	schema.run_batch(byte_array, stride, batch, raws.data());
+	return values == desired && raws == desired_raws;
+}
+
+static bool bit_schema_test_launcher()
+{
+	const int byte_count = 1010;
+
+	return test_launcher("bit_schema_test", 2'000, byte_count, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return bit_schema_test(byte_array, byte_count);
+	});
+}
+
+static bool bit_diff_test(const uint8_t* byte_array, const int byte_count, uint8_t* test_array)
+{
+	const int bit_count = (byte_count << 3);
+
+	// a range of byte_array copied to another bit address of test_array,
+	// with none or a few bits flipped; checked against a BIT_FLAG loop
+	int len = test_rand() % ((test_rand() % 2) ? 200 : (bit_count - 8));
+	int a_bit = test_rand() % (bit_count - len + 1);
+	int b_bit = test_rand() % (bit_count - len + 1);
+
+	for (int i = 0; i < byte_count; ++i)
+		test_array[i] = (uint8_t)test_rand();
+	BIT_WBITS_BUFFER(test_array, b_bit, len, byte_array, a_bit);
+	for (int i = 0, n = (len == 0) ? 0 : test_rand() % 4; i < n; ++i)
+	{
+		int bit = b_bit + test_rand() % len;
+		const int flag = BIT_FLAG(test_array, bit) ^ 1;
+		BIT_WFLAG(test_array, bit, flag);
+	}
+
+	int first = len, count = 0;
+	for (int i = len - 1; i >= 0; --i)
+	{
+		if (BIT_FLAG(byte_array, a_bit + i) != BIT_FLAG(test_array, b_bit + i))
+		{
+			first = i;
+			++count;
+		}
+	}
+
+	// first_diff_bit(a,a_bit,b,b_bit,len), count_diff_bits(a,a_bit,b,b_bit,len)
+	return first_diff_bit(byte_array, a_bit, test_array, b_bit, len) == (uint64_t)first &&
+		first_diff_bit(test_array, b_bit, byte_array, a_bit, len) == (uint64_t)first &&
+		count_diff_bits(byte_array, a_bit, test_array, b_bit, len) == (uint64_t)count &&
+		count_diff_bits(test_array, b_bit, byte_array, a_bit, len) == (uint64_t)count;
+}
+
+static bool bit_diff_test_launcher()
+{
+	const int byte_count = 1010;
+
+	return test_launcher("bit_diff_test", 10'000, byte_count, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return bit_diff_test(byte_array, byte_count, test_array);
+	});
+}
+
+static bool find_pattern_test(const uint8_t* byte_array, const int byte_count, uint8_t* test_array)
+{
+	const int bit_count = (byte_count << 3);
+
+	// a pattern of 1 - 64 bits planted a few times into random bits; checked
+	// against BIT_BITS at every position
+	int pattern_bits = 1 + test_rand() % 64;
+	uint64_t pattern = rand64() & MASK64(pattern_bits);
+	int len = test_rand() % ((test_rand() % 2) ? 300 : (bit_count + 1));
+	int start_bit = test_rand() % (bit_count - len + 1);
+
+	memcpy(test_array, byte_array, byte_count);
+	for (int i = 0, n = test_rand() % 8; i < n && len >= pattern_bits; ++i)
+	{
+		int bit = start_bit + test_rand() % (len - pattern_bits + 1);
+		BIT_WBITS(test_array, bit, pattern_bits, pattern);
+	}
+
+	std::vector<uint64_t> desired;
+	for (int bit = start_bit; bit + pattern_bits <= start_bit + len; ++bit)
+	{
+		uint64_t val;
+		BIT_BITS(test_array, bit, pattern_bits, val);
+		if (val == pattern)
+			desired.push_back(bit);
+	}
+
+	// find_pattern(buf,start_bit,len,pattern,pattern_bits,pos,max_pos)
+	std::vector<uint64_t> pos(desired.size() + 1);
+	if (find_pattern(test_array, start_bit, len, pattern, pattern_bits, pos.data(), pos.size()) != desired.size() ||
+		!std::equal(desired.begin(), desired.end(), pos.begin()))
+		return false;
+
+	// only the first 'max_pos' occurrences are written
+	std::fill(pos.begin(), pos.end(), ~0ULL);
+	const std::size_t max_pos = desired.size() / 2;
+	return find_pattern(test_array, start_bit, len, pattern, pattern_bits, pos.data(), max_pos) == desired.size() &&
+		std::equal(desired.begin(), desired.begin() + max_pos, pos.begin()) && pos[max_pos] == ~0ULL;
+}
+
+static bool find_pattern_test_launcher()
+{
+	const int byte_count = 1010;
+
+	return test_launcher("find_pattern_test", 2'000, byte_count, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return find_pattern_test(byte_array, byte_count, test_array);
+	});
+}
+
+static bool bit_rle_test(const uint8_t* byte_array, const int byte_count, uint8_t* test_array)
+{
+	const int bit_count = (byte_count << 3);
+
+	// runs of 0 - 300 bits, the first one possibly empty, decoded after some
+	// leading bits of a buffer filled with garbage; checked against BIT_WFLAG
+	std::vector<uint64_t> runs;
+	int dst_bit = test_rand() % 64;
+	int total = 0;
+	for (int i = 0, n = test_rand() % 40; i < n; ++i)
+	{
+		int len = ((i == 0) ? 0 : 1) + test_rand() % ((test_rand() % 4) ? 20 : 300);
+		if (total + len > bit_count - dst_bit)
+			break;
+		runs.push_back(len);
+		total += len;
+	}
+	if (runs.size() == 1 && runs[0] == 0)
+		runs.clear();
+
+	std::vector<uint8_t> desired(byte_count);
+	for (int i = 0; i < byte_count; ++i)
+		desired[i] = test_array[i] = (uint8_t)test_rand();
+	for (int i = 0, bit = dst_bit; i < (int)runs.size(); ++i)
+		for (uint64_t j = 0; j < runs[i]; ++j, ++bit)
+			BIT_WFLAG(desired.data(), bit, i & 1);
+
+	// bit_rle_decode(buf,bit,runs,n)
+	if (bit_rle_decode(test_array, dst_bit, runs.data(), runs.size()) != (uint64_t)(dst_bit + total) ||
+		memcmp(test_array, desired.data(), byte_count) != 0)
+		return false;
+
+	// bit_rle_encode(buf,bit,len,runs,max_runs), back to the same runs
+	std::vector<uint64_t> result(runs.size() + 1);
+	if (bit_rle_encode(test_array, dst_bit, total, result.data(), result.size()) != runs.size() ||
+		!std::equal(runs.begin(), runs.end(), result.begin()))
+		return false;
+
+	// a range of random bits, encoded and decoded again
+	int len = test_rand() % (bit_count + 1);
+	int src_bit = test_rand() % (bit_count - len + 1);
+	result.resize(len + 1);
+	std::size_t n = bit_rle_encode(byte_array, src_bit, len, result.data(), result.size());
+	for (int i = 0; i < byte_count; ++i)
+		desired[i] = test_array[i] = (uint8_t)test_rand();
+	BIT_WBITS_BUFFER(desired.data(), 0, len, byte_array, src_bit);
+	return bit_rle_decode(test_array, 0, result.data(), n) == (uint64_t)len &&
+		memcmp(test_array, desired.data(), byte_count) == 0;
+}
+
+static bool bit_rle_test_launcher()
+{
+	const int byte_count = 1010;
+
+	return test_launcher("bit_rle_test", 2'000, byte_count, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return bit_rle_test(byte_array, byte_count, test_array);
+	});
+}
+
+static bool bit_hdlc_test()
+{
+	// frames of 0 - 300 bits, mostly ones, stuffed in pieces between flags,
+	// some of them followed by an abort; the stuffing is checked against a
+	// BIT_FLAG loop, the unstuffing against the frames
+	const int frame_count = test_rand() % 4;
+	std::vector<std::vector<uint8_t>> frames(frame_count);
+	std::vector<bool> aborted(frame_count);
+	std::vector<uint8_t> stream(frame_count * 48 + 16), desired(stream.size()), result(stream.size());
+
+	HdlcStuffer stuffer;
+	BitWriter writer(stream.data(), 0);
+	int desired_bit = 0;
+	auto desired_put = [&](int b) { BIT_WFLAG(desired.data(), desired_bit, b); ++desired_bit; };
+	auto desired_flag = [&]() { for (int i = 0; i < 8; ++i) desired_put((0x7E >> (7 - i)) & 1); };
+
+	stuffer.flag(writer);
+	desired_flag();
+	for (int f = 0; f < frame_count; ++f)
+	{
+		int len = test_rand() % 301;
+		frames[f].resize(len);
+		for (int i = 0; i < len; ++i)
+			frames[f][i] = (test_rand() % 4) != 0;
+
+		std::vector<uint8_t> contents(len / 8 + 1);
+		for (int i = 0, ones = 0; i < len; ++i)
+		{
+			BIT_WFLAG(contents.data(), i, frames[f][i]);
+			desired_put(frames[f][i]);
+			ones = frames[f][i] ? (ones + 1) : 0;
+			if (ones == 5)
+			{
+				desired_put(0);
+				ones = 0;
+			}
+		}
+
+		for (int i = 0; i < len; /*_*/)
+		{
+			int n = 1 + test_rand() % 100;
+			n = (n < len - i) ? n : (len - i);
+			stuffer.stuff(contents.data(), i, n, writer);
+			i += n;
+		}
+
+		aborted[f] = (test_rand() % 4) == 0;
+		if (aborted[f])
+		{
+			writer.put(0x7F, 7);
+			for (int i = 0; i < 7; ++i)
+				desired_put(1);
+		}
+		stuffer.flag(writer);
+		desired_flag();
+	}
+
+	const int stream_bits = (int)writer.flush();
+	if (stream_bits != desired_bit)
+		return false;
+	for (int i = 0; i < stream_bits; ++i)
+		if (BIT_FLAG(stream.data(), i) != BIT_FLAG(desired.data(), i))
+			return false;
+
+	// unstuff in pieces; the frame before the first flag is empty
+	HdlcUnstuffer unstuffer;
+	BitWriter out(result.data(), 0);
+	uint64_t frame_start = 0;
+	int next = -1;
+	bool in_abort = false;
+	for (int bit = 0; bit < stream_bits; /*_*/)
+	{
+		int n = 1 + test_rand() % 100;
+		n = (n < stream_bits - bit) ? n : (stream_bits - bit);
+
+		uint64_t used;
+		HdlcEvent event = unstuffer.unstuff(stream.data(), bit, n, out, used);
+		bit += (int)used;
+		if (event == HDLC_END)
+			continue;
+
+		// an aborted frame ends with an abort followed by a flag
+		const bool abort = (next >= 0 && next < frame_count && aborted[next]);
+		if (next >= frame_count || (event == HDLC_ABORT && !abort) || (event == HDLC_FLAG && abort != in_abort))
+			return false;
+
+		if (event == HDLC_FLAG && !abort)
+		{
+			const uint64_t frame_bits = out.bit() - frame_start;
+			if (frame_bits != ((next < 0) ? 0 : frames[next].size()))
+				return false;
+			out.flush();
+			for (uint64_t i = 0; i < frame_bits; ++i)
+				if (BIT_FLAG(result.data(), frame_start + i) != frames[next][i])
+					return false;
+		}
+
+		in_abort = (event == HDLC_ABORT);
+		if (event == HDLC_FLAG)
+			++next;
+		frame_start = out.bit();
+	}
+
+	return next == frame_count;
+}
+
+static bool bit_hdlc_test_launcher()
+{
+	return test_launcher("bit_hdlc_test", 2'000, 0, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return bit_hdlc_test();
+	});
+}
+
+static bool bit_stream_test()
+{
+	// bitfields of 0 - 57 bits, half of them of 57 bits, read by a BitReader
+	// from a random bit address of an unpadded buffer; checked against BIT_BITS
+	const uint8_t ones[16] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+	BitReader first(ones, 0, 128);
+	if (first.get(57) != MASK64(57) || first.avail() < 0 || first.bit() != 57)
+		return false;
+
+	const int n = test_rand() % 100;
+	std::vector<int> lens(n);
+	int total = 0;
+	for (int& len : lens)
+	{
+		len = (test_rand() % 2) ? 57 : test_rand() % 58;
+		total += len;
+	}
+	const int bit = test_rand() % 64;
+	std::vector<uint8_t> buf((bit + total + 7) / 8 + 1);
+	for (uint8_t& b : buf)
+		b = (uint8_t)test_rand();
+
+	BitReader in(buf.data(), bit, total);
+	int pos = bit;
+	for (int len : lens)
+	{
+		uint64_t desired = 0;
+		if (len != 0)
+			BIT_BITS(buf.data(), pos, len, desired);
+		if (in.get(len) != desired || in.avail() < 0)
+			return false;
+		pos += len;
+		if (in.bit() != (uint64_t)pos)
+			return false;
+	}
+	return in.left() == 0;
+}
+
+static bool bit_stream_test_launcher()
+{
+	return test_launcher("bit_stream_test", 2'000, 0, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return bit_stream_test();
+	});
+}
+
+static bool bit_rice_test()
+{
+	// residuals of about k bits with some outliers, coded after some leading
+	// bits of a buffer filled with garbage; the codes are checked against a
+	// BIT_WFLAG loop
+	const int k = test_rand() % 33;
+	const int n = test_rand() % 200;
+	std::vector<int64_t> values(n), result(n + 1);
+	std::vector<uint8_t> code;
+	for (int i = 0; i < n; ++i)
+	{
+		int bits = k + test_rand() % 6 + ((test_rand() % 50) ? 0 : 10);
+		values[i] = (bits == 0) ? 0 : (int64_t)(rand64() >> (64 - bits));
+		values[i] = (test_rand() % 2) ? -values[i] : values[i];
+
+		uint64_t u = ((uint64_t)values[i] << 1) ^ (uint64_t)(values[i] >> 63);
+		code.insert(code.end(), (std::size_t)(u >> k), 0);
+		code.push_back(1);
+		for (int j = k - 1; j >= 0; --j)
+			code.push_back((u >> j) & 1);
+	}
+
+	const int dst_bit = test_rand() % 64;
+	const int total = (int)code.size();
+	std::vector<uint8_t> buf((dst_bit + total) / 8 + 1);
+	for (uint8_t& b : buf)
+		b = (uint8_t)test_rand();
+	const std::vector<uint8_t> garbage = buf;
+
+	// rice_encode_n(out,k,src,n)
+	BitWriter out(buf.data(), dst_bit);
+	rice_encode_n(out, k, values.data(), n);
+	if (out.flush() != (uint64_t)(dst_bit + total))
+		return false;
+	for (int i = 0; i < total; ++i)
+		if (BIT_FLAG(buf.data(), dst_bit + i) != code[i])
+			return false;
+	for (int i = 0; i < dst_bit; ++i)
+		if (BIT_FLAG(buf.data(), i) != BIT_FLAG(garbage.data(), i))
+			return false;
+
+	// rice_decode_n(in,k,dst,n), of the whole range and of a truncated one
+	BitReader in(buf.data(), dst_bit, total);
+	if (rice_decode_n(in, k, result.data(), n + 1) != (std::size_t)n || in.left() != 0 ||
+		!std::equal(values.begin(), values.end(), result.begin()))
+		return false;
+
+	if (n > 0)
+	{
+		BitReader part(buf.data(), dst_bit, total - 1 - test_rand() % total);
+		std::size_t m = rice_decode_n(part, k, result.data(), n);
+		if (m >= (std::size_t)n || !std::equal(values.begin(), values.begin() + m, result.begin()))
+			return false;
+	}
+
+	// rice_encode_adaptive_n(out,state,src,n), rice_decode_adaptive_n(in,state,dst,n);
+	// skipped if the parameter adapts too slowly to the first values
+	RiceAdaptive enc, dec;
+	uint64_t adaptive_bits = 0;
+	for (int i = 0; i < n; ++i)
+	{
+		uint64_t u = ((uint64_t)values[i] << 1) ^ (uint64_t)(values[i] >> 63);
+		adaptive_bits += (u >> enc.k()) + 1 + enc.k();
+		enc.update(u);
+	}
+	if (adaptive_bits > (1 << 20))
+		return true;
+
+	enc = RiceAdaptive();
+	std::vector<uint8_t> adaptive((std::size_t)(dst_bit + adaptive_bits) / 8 + 1);
+	BitWriter aout(adaptive.data(), dst_bit);
+	rice_encode_adaptive_n(aout, enc, values.data(), n / 2);
+	rice_encode_adaptive_n(aout, enc, values.data() + n / 2, n - n / 2);
+	BitReader ain(adaptive.data(), dst_bit, aout.flush() - dst_bit);
+	return rice_decode_adaptive_n(ain, dec, result.data(), n + 1) == (std::size_t)n && ain.left() == 0 &&
+		std::equal(values.begin(), values.end(), result.begin()) && enc.sum == dec.sum;
+}
+
+static bool bit_rice_test_launcher()
+{
+	return test_launcher("bit_rice_test", 2'000, 0, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return bit_rice_test();
+	});
+}
+
+static bool elias_fano_test()
+{
+	// bit_select64(val,idx), of sparse and dense words, against clearing the
+	// lower set bits one by one
+	for (int i = 0; i < 100; ++i)
+	{
+		const uint64_t val = (i % 3 == 0) ? (rand64() & rand64() & rand64()) : ((i % 3 == 1) ? rand64() : (rand64() | rand64()));
+		if (val == 0)
+			continue;
+		const int idx = test_rand() % bit_popcount64(val);
+		uint64_t low = val;
+		for (int j = 0; j < idx; ++j)
+			low &= low - 1;
+		if (bit_select64(val, idx) != bit_ctz64(low))
+			return false;
+	}
+
+	// ascending values with random gaps, some repeated; checked against the
+	// array by get, iteration and next_geq (as std::lower_bound)
+	const int n = test_rand() % 3000;
+	const int gap_bits = test_rand() % 40;
+	std::vector<uint64_t> values(n);
+	for (int i = 0; i < n; ++i)
+		values[i] = (i == 0 ? 0 : values[i - 1]) + ((gap_bits == 0) ? test_rand() % 2 : (rand64() >> (64 - gap_bits)));
+
+	EliasFano ef(values.data(), values.size());
+	if (ef.size() != values.size())
+		return false;
+	for (int i = 0; i < n; ++i)
+		if (ef.get(i) != values[i])
+			return false;
+	if (!std::equal(ef.begin(), ef.end(), values.begin()))
+		return false;
+
+	for (int i = 0; i < 200 && n > 0; ++i)
+	{
+		uint64_t x = (test_rand() % 8 == 0) ? values[test_rand() % n] : (rand64() % (values[n - 1] + 2));
+		std::size_t desired = std::lower_bound(values.begin(), values.end(), x) - values.begin();
+		if (ef.next_geq(x) != desired || (desired < (std::size_t)n && *ef.lower_bound(x) != values[desired]))
+			return false;
+	}
+
+	// up to 3 + low_len() bits per value, less than one more for the samples
+	return ef.bit_size() <= (uint64_t)n * (ef.low_len() + 4) + 1024;
+}
+
+static bool elias_fano_test_launcher()
+{
+	return test_launcher("elias_fano_test", 500, 0, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return elias_fano_test();
+	});
+}
+
+static bool bit_parallel_test()
+{
+	// values of a random width packed at a random bit address of a buffer
+	// filled with garbage, on a pool of 4 threads (with chunks sharing bytes
+	// for most widths) and on the shared pool; checked against bit_pack,
+	// bit_unpack and concat_bits
+	static BitThreadPool pool(4);
+	const int len = 1 + test_rand() % 64;
+	const int n = test_rand() % 20000;
+	const int bit = test_rand() % 64;
+	const uint64_t total = (uint64_t)n * len;
+	std::vector<uint64_t> values(n), result(n);
+	for (uint64_t& val : values)
+		val = rand64();
+
+	std::vector<uint8_t> garbage((std::size_t)((bit + total) / 8 + 2));
+	for (uint8_t& b : garbage)
+		b = (uint8_t)test_rand();
+	std::vector<uint8_t> desired = garbage, buf = garbage;
+	bit_pack(desired.data(), bit, len, values.data(), n);
+
+	// bit_pack_parallel(buf,bit,len,src,n,pool)
+	bit_pack_parallel(buf.data(), bit, len, values.data(), n, pool);
+	if (buf != desired)
+		return false;
+	buf = garbage;
+	bit_pack_parallel(buf.data(), bit, len, values.data(), n);
+	if (buf != desired)
+		return false;
+
+	// bit_unpack_parallel(buf,bit,len,dst,n,pool)
+	bit_unpack_parallel(desired.data(), bit, len, result.data(), n, pool);
+	for (int i = 0; i < n; ++i)
+		if (result[i] != (values[i] & MASK64(len)))
+			return false;
+
+	// bit_copy_parallel(buf,bit,len,src,src_bit,pool), of the packed bits
+	const int dst_bit = test_rand() % 64;
+	std::vector<uint8_t> copy((std::size_t)((dst_bit + total) / 8 + 2));
+	for (uint8_t& b : copy)
+		b = (uint8_t)test_rand();
+	std::vector<uint8_t> copy_desired = copy;
+	BitFragment frag = { desired.data(), (uint64_t)bit, total };
+	(void)concat_bits(copy_desired.data(), dst_bit, &frag, 1);
+	bit_copy_parallel(copy.data(), dst_bit, total, desired.data(), bit, pool);
+	return copy == copy_desired;
+}
+
+static bool bit_parallel_test_launcher()
+{
+	return test_launcher("bit_parallel_test", 300, 0, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return bit_parallel_test();
+	});
+}
+
+static bool bit_multi_test()
+{
+	// messages of a random layout of fixed lengths and 6-bit length prefixes,
+	// written by a BitWriter after some leading bits of padded buffers and
+	// decoded 8, 3 and 1 at a time
+	const int k = 1 + test_rand() % 8;
+	const int count = test_rand() % 40;
+	std::vector<int> lens(k);
+	for (int j = 0; j < k; ++j)
+		lens[j] = (j > 0 && lens[j - 1] == 6 && test_rand() % 2) ? -1 : ((test_rand() % 4) ? test_rand() % 58 : 6);
+
+	const int lead = test_rand() % 64;
+	std::vector<std::vector<uint8_t>> bufs(count);
+	std::vector<const void*> msgs(count), skipped(count);
+	std::vector<uint64_t> desired((std::size_t)count * k);
+	for (int m = 0; m < count; ++m)
+	{
+		bufs[m].resize((lead + k * 57) / 8 + 1 + BYTE_PADDING);
+		for (uint8_t& b : bufs[m])
+			b = (uint8_t)test_rand();
+		BitWriter out(bufs[m].data(), 0);
+		out.put(rand64(), lead);
+		for (int j = 0; j < k; ++j)
+		{
+			const int len = (lens[j] >= 0) ? lens[j] : (int)desired[m * k + j - 1];
+			uint64_t val = (len == 0) ? 0 : (rand64() >> (64 - len));
+			if (j + 1 < k && lens[j + 1] < 0)
+				val = test_rand() % 58;
+			out.put(val, len);
+			desired[m * k + j] = val;
+		}
+		out.flush();
+		msgs[m] = bufs[m].data() + lead / 8;
+		skipped[m] = bufs[m].data();
+	}
+
+	// BitMultiReader<3>, skipping the leading bits
+	for (int m = 0; m + 3 <= count; m += 3)
+	{
+		BitMultiReader<3> in(&skipped[m]);
+		in.skip(lead);
+		for (int j = 0; j < k; ++j)
+		{
+			uint64_t vals[3];
+			int prefixed[3];
+			for (int i = 0; i < 3; ++i)
+				prefixed[i] = (j > 0) ? (int)desired[(m + i) * k + j - 1] : 0;
+			if (lens[j] >= 0)
+				in.get(lens[j], vals);
+			else
+				in.get(prefixed, vals);
+			for (int i = 0; i < 3; ++i)
+				if (vals[i] != desired[(m + i) * k + j])
+					return false;
+		}
+	}
+
+	// bit_decode_messages(msgs,count,lens,k,out), of messages at bit address
+	// 'lead % 8' moved to 0 by a leading field
+	std::vector<int> lens_lead(lens);
+	lens_lead.insert(lens_lead.begin(), lead % 8);
+	std::vector<uint64_t> result_lead((std::size_t)count * (k + 1));
+	bit_decode_messages(msgs.data(), count, lens_lead.data(), k + 1, result_lead.data());
+	for (int m = 0; m < count; ++m)
+		for (int j = 0; j < k; ++j)
+			if (result_lead[m * (k + 1) + j + 1] != desired[m * k + j])
+				return false;
+
+	bit_decode_messages<3>(msgs.data(), count, lens_lead.data(), k + 1, result_lead.data());
+	for (int m = 0; m < count; ++m)
+		for (int j = 0; j < k; ++j)
+			if (result_lead[m * (k + 1) + j + 1] != desired[m * k + j])
+				return false;
+	return true;
+}
+
+static bool bit_multi_test_launcher()
+{
+	return test_launcher("bit_multi_test", 2'000, 0, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return bit_multi_test();
+	});
+}
+
+#if BIT_HAVE_COROUTINE
+// a message of the coroutine test: a 57-bit stamp at a byte boundary, a
+// 6-bit count of fields, every field a 5-bit length and a value of that
+// length, padded to a byte boundary
+static BitTask<uint64_t> bit_coroutine_field(BitCoReader& in)
+{
+	const int len = (int)co_await in.bits(5);
+	co_return co_await in.bits(len);
+}
+
+static BitTask<> bit_coroutine_messages(BitCoReader& in, std::vector<uint64_t>& out, int count)
+{
+	for (int m = 0; m < count; ++m)
+	{
+		out.push_back(co_await in.bits(57));
+		const uint64_t n = co_await in.bits(6);
+		out.push_back(n);
+		for (uint64_t i = 0; i < n; ++i)
+			out.push_back(co_await bit_coroutine_field(in));
+		in.align();
+	}
+}
+
+static bool bit_coroutine_test()
+{
+	// messages written by a BitWriter and some trailing garbage, passed to
+	// the routines in random pieces
+	const int count = test_rand() % 20;
+	std::vector<uint64_t> desired, result;
+	std::vector<uint8_t> stream(count * 308 + 16);   // up to 57 + 6 + 63 * 36 bits per message
+	BitWriter out(stream.data(), 0);
+	for (int m = 0; m < count; ++m)
+	{
+		const uint64_t stamp = rand64() >> 7;
+		out.put(stamp, 57);
+		desired.push_back(stamp);
+		const int n = test_rand() % 64;
+		out.put(n, 6);
+		desired.push_back(n);
+		for (int i = 0; i < n; ++i)
+		{
+			const int len = test_rand() % 32;
+			const uint64_t val = (len == 0) ? 0 : (rand64() >> (64 - len));
+			out.put(len, 5);
+			out.put(val, len);
+			desired.push_back(val);
+		}
+		out.put(0, (int)((8 - out.bit() % 8) % 8));
+	}
+	const std::size_t bytes = (std::size_t)(out.flush() / 8);
+	for (std::size_t i = bytes; i < stream.size(); ++i)
+		stream[i] = (uint8_t)test_rand();
+
+	BitCoReader in;
+	BitTask<> task = bit_coroutine_messages(in, result, count);
+	task.start();
+	// pieces of 0 - 15 bytes, or of 8 - 23 bytes, which the 8-byte loads
+	// consume; a waiting routine takes some bytes of every piece
+	const int min_piece = (test_rand() % 2) ? 8 : 0;
+	std::size_t taken = 0;
+	while (!task.done() && taken < stream.size())
+	{
+		const std::size_t size = std::min<std::size_t>(min_piece + test_rand() % 16, stream.size() - taken);
+		const std::size_t piece = in.feed(stream.data() + taken, size);
+		if (piece == 0 && size != 0 && !task.done())
+			return false;
+		taken += piece;
+	}
+	task.result();
+
+	// at most one frame of either routine is allocated, the others are recycled
+	return task.done() && result == desired && in.bit() == bytes * 8 &&
+		taken * 8 == in.bit() + in.avail() && in.pool().allocations() <= 2;
+}
+
+static bool bit_coroutine_test_launcher()
+{
+	return test_launcher("bit_coroutine_test", 2'000, 0, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return bit_coroutine_test();
+	});
+}
+#endif
+
+template<int _N>
+static bool byte_bytes_n_test(const uint8_t* buf)
+{
+	uint64_t be = 0, le = 0;
+	BYTE_BYTES(buf, _N, be);
+	BYTE_BYTES_LE(buf, _N, le);
+	return byte_bytes<_N>(buf) == be && byte_bytes_le<_N>(buf) == le;
+}
+
+static bool byte_padded_test()
+{
+	// the padded and the compile-time byte paths, checked against BYTE_BYTES
+	// and BYTE_WBYTES at random offsets of a padded buffer
+	std::vector<uint8_t> buf(64 + BYTE_PADDING), desired;
+	for (uint8_t& b : buf)
+		b = (uint8_t)test_rand();
+
+	for (int rep = 0; rep < 100; ++rep)
+	{
+		const int off = test_rand() % 64;
+		const int len = 1 + test_rand() % 8;
+		const uint8_t* in = buf.data() + off;
+
+		// BYTE_BYTES_PADDED_INC, BYTE_BYTES_LE_PADDED(buf,len,ret)
+		uint64_t be = 0, le = 0, be_padded = 0, le_padded = 0;
+		BYTE_BYTES(in, len, be);
+		BYTE_BYTES_LE(in, len, le);
+		BYTE_BYTES_PADDED_INC(in, len, be_padded);
+		BYTE_BYTES_LE_PADDED(buf.data() + off, len, le_padded);
+		if (be_padded != be || le_padded != le || in != buf.data() + off + len)
+			return false;
+
+		// BYTE_WBYTES_PADDED_INC, BYTE_WBYTES_LE_PADDED(buf,len,val)
+		const uint64_t value = rand64();
+		uint8_t* out = buf.data() + off;
+		desired = buf;
+		BYTE_WBYTES(desired.data() + off, len, value);
+		BYTE_WBYTES_PADDED_INC(out, len, value);
+		if (buf != desired || out != buf.data() + off + len)
+			return false;
+		BYTE_WBYTES_LE(desired.data() + off, len, ~value);
+		BYTE_WBYTES_LE_PADDED(buf.data() + off, len, ~value);
+		if (buf != desired)
+			return false;
+
+		// byte_bytes<N>(buf), byte_bytes_le<N>(buf)
+		in = buf.data() + off;
+		if (!(byte_bytes_n_test<1>(in) && byte_bytes_n_test<2>(in) && byte_bytes_n_test<3>(in) && byte_bytes_n_test<4>(in) &&
+			byte_bytes_n_test<5>(in) && byte_bytes_n_test<6>(in) && byte_bytes_n_test<7>(in) && byte_bytes_n_test<8>(in)))
+			return false;
+	}
+	return true;
+}
+
+static bool byte_padded_test_launcher()
+{
+	return test_launcher("byte_padded_test", 2'000, 0, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return byte_padded_test();
+	});
+}
+
+// the fast paths, checked against BIT_BITS and BIT_WBITS as the reference;
+// every reader extracts a bitfield from a padded buffer, every writer writes
+// one to a buffer of whole 8-byte words
+struct fast_path
+{
+	const char* name;
+	int max_len;
+	uint64_t(*read)(const uint8_t* buf, int bit, int len);
+	void(*write)(uint8_t* buf, int bit, int len, uint64_t val);
+};
+
+static const fast_path fast_paths[] = {
+	{ "BIT_BITS_PADDED", BIT_PADDED_MAX_LEN,
+		[](const uint8_t* buf, int bit, int len) { uint64_t ret; BIT_BITS_PADDED(buf, bit, len, ret); return ret; },
+		[](uint8_t* buf, int bit, int len, uint64_t val) { BIT_WBITS_PADDED(buf, bit, len, val); } },
+	{ "BIT_GATHER_ONE", 64,
+		[](const uint8_t* buf, int bit, int len) { return (uint64_t)BIT_GATHER_ONE(buf, ADDR(bit), OFFSET(bit), 64 - len); },
+		nullptr },
+	{ "bit_unpack/bit_pack", 64,
+		[](const uint8_t* buf, int bit, int len) { uint64_t ret; bit_unpack(buf, bit, len, &ret, 1); return ret; },
+		[](uint8_t* buf, int bit, int len, uint64_t val) { bit_pack(buf, bit, len, &val, 1); } },
+	{ "bits_extract/bits_deposit", 64,
+		[](const uint8_t* buf, int bit, int len) { return bits_extract(buf, bit, len, ~(uint64_t)0); },
+		[](uint8_t* buf, int bit, int len, uint64_t val) { bits_deposit(buf, bit, len, ~(uint64_t)0, val); } },
+	{ "bit_wbits_atomic", 64,
+		nullptr,
+		[](uint8_t* buf, int bit, int len, uint64_t val) { bit_wbits_atomic(buf, bit, len, val); } },
+};
+
+static bool fast_path_test(const uint8_t* byte_array, const int byte_count, uint8_t* test_array)
+{
+	const int bit_count = ((byte_count - BYTE_PADDING) << 3);
+
+	std::vector<uint64_t> words((byte_count + 7) >> 3), desired_words((byte_count + 7) >> 3);
+	uint8_t* test_buf = (uint8_t*)words.data();
+	uint8_t* desired_buf = (uint8_t*)desired_words.data();
+
+	for (const fast_path& path : fast_paths)
+	{
+		memcpy(test_buf, byte_array, byte_count);
+		memcpy(desired_buf, byte_array, byte_count);
+
+		for (int rep = 0; rep < 1000; ++rep)
+		{
+			int bit_field_len = 1 + test_rand() % path.max_len;
+			int bit_index = test_rand() % (bit_count - bit_field_len + 1);
+
+			uint64_t desired = 0;
+			BIT_BITS(byte_array, bit_index, bit_field_len, desired);
+			if (path.read != nullptr && path.read(byte_array, bit_index, bit_field_len) != desired)
+			{
+				printf("%s: bit %d, len %d \n", path.name, bit_index, bit_field_len);
+				return false;
+			}
+
+			uint64_t value = rand64() & MASK64(bit_field_len);
+			if (path.write != nullptr)
+			{
+				path.write(test_buf, bit_index, bit_field_len, value);
+				BIT_WBITS(desired_buf, bit_index, bit_field_len, value);
+				if (memcmp(test_buf, desired_buf, byte_count) != 0)
+				{
+					printf("%s: bit %d, len %d \n", path.name, bit_index, bit_field_len);
+					return false;
+				}
+			}
+		}
+	}
+
+	(void)test_array;
+	return true;
+}
+
+static bool fast_path_test_launcher()
+{
+	const int byte_count = 256;
+
+	return test_launcher("fast_path_test", 200, byte_count, [&](const uint8_t* bit_array, const uint8_t* byte_array, uint8_t* test_array) {
+		return fast_path_test(byte_array, byte_count, test_array);
+	});
+}
+
+int main(int argc, char* argv[])
+{
+	// bit_bits_test [seed] - with a seed, one repetition of every test runs with it
+	if (argc > 1)
+	{
+		test_base_seed = strtoull(argv[1], nullptr, 0);
+		test_single_seed = true;
+	}
+	else
+	{
+		test_base_seed = test_mix((uint64_t)std::chrono::steady_clock::now().time_since_epoch().count());
+	}
+
+	test_thread_count = (int)std::thread::hardware_concurrency();
+	if (test_thread_count < 1)
+		test_thread_count = 1;
+
+	if (test_single_seed)
+		printf("seed 0x%016llx \n", (unsigned long long)test_base_seed);
+	printf("%d threads \n", test_thread_count);
+
+	bool ret = true;
+	ret = bit_bits_test_launcher() && ret;
+	ret = bit_wbits_test_launcher() && ret;
+	ret = bit_wbits_zero_test_launcher() && ret;
+	ret = packed_array_test_launcher() && ret;
+	ret = bit_atomic_test_launcher() && ret;
+	ret = gather_bits_test_launcher() && ret;
+	ret = bits_extract_test_launcher() && ret;
+	ret = bit_reverse_test_launcher() && ret;
+	ret = bit_transpose_test_launcher() && ret;
+	ret = bit_morton_test_launcher() && ret;
+	ret = bit_constexpr_test_launcher() && ret;
+	ret = bit_scan_test_launcher() && ret;
+	ret = bit_stats_test_launcher() && ret;
+	ret = bit_instrument_test_launcher() && ret;
+	ret = concat_bits_test_launcher() && ret;
+	ret = bit_crc_test_launcher() && ret;
+	ret = bit_schema_test_launcher() && ret;
+	ret = bit_diff_test_launcher() && ret;
+	ret = find_pattern_test_launcher() && ret;
+	ret = bit_rle_test_launcher() && ret;
+	ret = bit_hdlc_test_launcher() && ret;
+	ret = bit_stream_test_launcher() && ret;
+	ret = bit_rice_test_launcher() && ret;
+	ret = elias_fano_test_launcher() && ret;
+	ret = bit_parallel_test_launcher() && ret;
+	ret = bit_multi_test_launcher() && ret;
+#if BIT_HAVE_COROUTINE
+	ret = bit_coroutine_test_launcher() && ret;
+#endif
+	ret = byte_padded_test_launcher() && ret;
+	ret = fast_path_test_launcher() && ret;
+
+	printf("\n%s \n", ret ? "all tests passed" : "some tests failed");
+	return ret ? 0 : 1;
 }
@@ -0,0 +1,194 @@
+/* bit_constexpr.h
+ * constexpr equivalents of the extracting, writing and byte-order functions,
+ * working on std::array buffers, so that message templates, masks and lookup
+ * tables can be built at compile time. requires C++17.
+ */
+
+#ifndef __BIT_CONSTEXPR_H__
+#define __BIT_CONSTEXPR_H__
+
+#pragma warning(disable : 26451)
+
+#include <array>
+#include <cstddef>
+
+#include "bit_bits.h"
+
+/********************************************************************
+ * utility functions
+ */
+
+/* reverse the byte order of a long long (64 bit, 8 byte) */
+static constexpr uint64_t byte_swap64_cx(uint64_t val)
+{
+    uint64_t ret = 0;
+    for (int i = 0; i < 8; ++i, val >>= 8)
+        ret = (ret << 8) | (val & 0xFF);
+    return ret;
+}
+
+/* reverse the byte order of a long (32 bit, 4 byte) */
+static constexpr uint32_t byte_swap32_cx(uint32_t val)
+{
+    return (uint32_t)(byte_swap64_cx(val) >> 32);
+}
+
+/* reverse the byte order of a short (16 bit, 2 byte) */
+static constexpr uint16_t byte_swap16_cx(uint16_t val)
+{
+    return (uint16_t)(byte_swap64_cx(val) >> 48);
+}
+
+/********************************************************************
+ * Functions for extracting and writing bytes, as BYTE_BYTES(_LE) and
+ *     BYTE_WBYTES(_LE)
+ */
+
+/* extract bytes with custom length up to 8 byte with big-endian representation
+ * buf ... buffer
+ * off ... byte offset
+ * len ... number of bytes
+ */
+template<std::size_t _N>
+static constexpr uint64_t byte_bytes_cx(const std::array<uint8_t, _N>& buf, std::size_t off, int len)
+{
+    uint64_t ret = 0;
+    for (int i = 0; i < len; ++i)
+        ret = (ret << 8) | buf[off + i];
+    return ret;
+}
+
+/* extract bytes with custom length up to 8 byte with little-endian representation
+ * buf ... buffer
+ * off ... byte offset
+ * len ... number of bytes
+ */
+template<std::size_t _N>
+static constexpr uint64_t byte_bytes_le_cx(const std::array<uint8_t, _N>& buf, std::size_t off, int len)
+{
+    uint64_t ret = 0;
+    for (int i = len - 1; i >= 0; --i)
+        ret = (ret << 8) | buf[off + i];
+    return ret;
+}
+
+/* write value with custom length up to 8 byte with big-endian representation
+ * buf ... buffer
+ * off ... byte offset
+ * len ... number of bytes
+ * val ... value to write
+ */
+template<std::size_t _N>
+static constexpr void byte_wbytes_cx(std::array<uint8_t, _N>& buf, std::size_t off, int len, uint64_t val)
+{
+    for (int i = len - 1; i >= 0; --i, val >>= 8)
+        buf[off + i] = (uint8_t)(val & 0xFF);
+}
+
+/* write value with custom length up to 8 byte with little-endian representation
+ * buf ... buffer
+ * off ... byte offset
+ * len ... number of bytes
+ * val ... value to write
+ */
+template<std::size_t _N>
+static constexpr void byte_wbytes_le_cx(std::array<uint8_t, _N>& buf, std::size_t off, int len, uint64_t val)
+{
+    for (int i = 0; i < len; ++i, val >>= 8)
+        buf[off + i] = (uint8_t)(val & 0xFF);
+}
+
+/********************************************************************
+ * Functions for extracting and writing bitfields, as BIT_FLAG, BIT_BITS,
+ *     BIT_WFLAG and BIT_WBITS
+ */
+
+/* extract bitfield with custom length up to 64 bits
+ * buf ... buffer
+ * bit ... bit address
+ * len ... length of bitfield
+ */
+template<std::size_t _N>
+static constexpr uint64_t bit_bits_cx(const std::array<uint8_t, _N>& buf, uint64_t bit, int len)
+{
+    /* the 64-bit window starting at 'bit', completed by a ninth byte */
+    const std::size_t addr = (std::size_t)ADDR(bit);
+    const int off = (int)OFFSET(bit);
+    uint64_t head = 0;
+    for (std::size_t i = addr; i < addr + 8; ++i)
+        head = (head << 8) | ((i < _N) ? buf[i] : 0);
+    uint64_t next = (addr + 8 < _N) ? buf[addr + 8] : 0;
+
+    return ((head << off) | (next >> (8 - off))) >> (64 - len);
+}
+
+/* extract a single bit
+ * buf ... buffer
+ * bit ... bit address
+ */
+template<std::size_t _N>
+static constexpr uint64_t bit_flag_cx(const std::array<uint8_t, _N>& buf, uint64_t bit)
+{
+    return (buf[(std::size_t)ADDR(bit)] >> SHIFT(bit, 1)) & MASK8(1);
+}
+
+/* write value in a bitfield with custom length up to 64 bits
+ * buf ... buffer
+ * bit ... bit address
+ * len ... length of bitfield
+ * val ... value to write
+ */
+template<std::size_t _N>
+static constexpr void bit_wbits_cx(std::array<uint8_t, _N>& buf, uint64_t bit, int len, uint64_t val)
+{
+    for (int done = 0; done < len; /*_*/)
+    {
+        const uint64_t pos = bit + done;
+        const int part = ((int)BIT_IN_FIRST(pos) < len - done) ? (int)BIT_IN_FIRST(pos) : (len - done);
+        const int shift = (int)BIT_IN_FIRST(pos) - part;
+        const uint32_t mask = MASK8(part) << shift;
+        const uint32_t bits = (uint32_t)((val >> (len - done - part)) & MASK8(part)) << shift;
+
+        uint8_t& ref = buf[(std::size_t)ADDR(pos)];
+        ref = (uint8_t)((ref & ~mask) | bits);
+        done += part;
+    }
+}
+
+/* write a single bit
+ * buf ... buffer
+ * bit ... bit address
+ * val ... value to write
+ */
+template<std::size_t _N>
+static constexpr void bit_wflag_cx(std::array<uint8_t, _N>& buf, uint64_t bit, uint64_t val)
+{
+    bit_wbits_cx(buf, bit, 1, val);
+}
+
+/********************************************************************
+ * Functions for building buffers at compile time
+ */
+
+/* a bitfield of a template: bit address, length and value */
+struct BitFieldCx
+{
+    uint64_t bit;
+    int len;
+    uint64_t val;
+};
+
+/* build a buffer of '_N' bytes from a list of bitfields; bits which are not
+ *     covered by any bitfield are zero
+ * fields  list of bitfields, e.g. {{ 0, 8, 0xD3 }, { 8, 6, 0 }, { 14, 10, 19 }}
+ */
+template<std::size_t _N, std::size_t _K>
+static constexpr std::array<uint8_t, _N> bit_template_cx(const BitFieldCx (&fields)[_K])
+{
+    std::array<uint8_t, _N> ret{};
+    for (std::size_t i = 0; i < _K; ++i)
+        bit_wbits_cx(ret, fields[i].bit, fields[i].len, fields[i].val);
+    return ret;
+}
+
+#endif /* __BIT_CONSTEXPR_H__ */
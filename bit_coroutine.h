@@ -0,0 +1,388 @@
+/* bit_coroutine.h
+ * definitions for decoding bitstreams which arrive in pieces, e.g. partial
+ * reads of pipes and sockets, by parse routines written as coroutines: a
+ * routine reads bitfields by 'co_await in.bits(len)' and is suspended when
+ * the received bytes run out, to be resumed where it stopped once more bytes
+ * arrive, so an incomplete message is never parsed again. requires C++20;
+ * the definitions are skipped by compilers without coroutines.
+ */
+
+#ifndef __BIT_COROUTINE_H__
+#define __BIT_COROUTINE_H__
+
+#pragma warning(disable : 26451)
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define BIT_HAVE_COROUTINE 1
+#endif
+#endif
+#ifndef BIT_HAVE_COROUTINE
+#define BIT_HAVE_COROUTINE 0
+#endif
+
+#if BIT_HAVE_COROUTINE
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <utility>
+
+#include "bit_bits.h"
+
+/* number of size classes (of 64 bytes) of recycled coroutine frames; larger
+ *     frames are allocated on every call
+ */
+#define BIT_FRAME_CLASSES 32
+
+/********************************************************************
+ * BitFramePool - recycled memory for the frames of parse routines. a freed
+ *     frame is kept in the free list of its size class and handed to the
+ *     next routine of that class, so once every routine has run, calling
+ *     routines does not allocate. frames are taken and freed by the thread
+ *     decoding the stream; all frames must be freed before the pool.
+ */
+class BitFramePool
+{
+public:
+    BitFramePool() : allocations_(0)
+    {
+        for (Frame*& list : free_)
+            list = nullptr;
+    }
+
+    ~BitFramePool()
+    {
+        for (Frame* list : free_)
+        {
+            while (list != nullptr)
+            {
+                Frame* next = list->next;
+                ::operator delete(list);
+                list = next;
+            }
+        }
+    }
+
+    BitFramePool(const BitFramePool&) = delete;
+    BitFramePool& operator=(const BitFramePool&) = delete;
+
+    /* number of frames allocated from the heap so far */
+    std::size_t allocations() const { return allocations_; }
+
+    /* take a frame of 'size' bytes */
+    void* allocate(std::size_t size)
+    {
+        const std::size_t cls = (size + sizeof(Frame) + 63) >> 6;
+        Frame* frame;
+        if (cls < BIT_FRAME_CLASSES && free_[cls] != nullptr)
+        {
+            frame = free_[cls];
+            free_[cls] = frame->next;
+        }
+        else
+        {
+            frame = (Frame*)::operator new(cls << 6);
+            ++allocations_;
+        }
+        frame->pool = this;
+        frame->cls = cls;
+        return frame + 1;
+    }
+
+    /* return a frame to the pool which it was taken from */
+    static void deallocate(void* ptr)
+    {
+        Frame* frame = (Frame*)ptr - 1;
+        if (frame->cls < BIT_FRAME_CLASSES)
+        {
+            frame->next = frame->pool->free_[frame->cls];
+            frame->pool->free_[frame->cls] = frame;
+        }
+        else
+        {
+            ::operator delete(frame);
+        }
+    }
+
+private:
+    /* the header preceding a frame */
+    struct alignas(16) Frame
+    {
+        BitFramePool* pool;
+        std::size_t cls;
+        Frame* next;
+    };
+
+    Frame* free_[BIT_FRAME_CLASSES];
+    std::size_t allocations_;
+};
+
+class BitCoReader;
+
+/* the value returned by a routine, kept in its promise */
+template<typename _RetTy>
+struct BitTaskResult
+{
+    _RetTy value_{};
+
+    void return_value(_RetTy value) { value_ = std::move(value); }
+    _RetTy take() { return std::move(value_); }
+};
+
+template<>
+struct BitTaskResult<void>
+{
+    void return_void() {}
+    void take() {}
+};
+
+/********************************************************************
+ * BitTask - the result of a parse routine, a coroutine returning '_RetTy'
+ *     (or void) whose first parameter is the 'BitCoReader&' it reads from;
+ *     the frame of the routine is taken from the pool of that reader. a
+ *     routine starts when it is awaited by another routine, which goes on
+ *     once it returns, or by start(); exceptions are passed to the
+ *     awaiting routine, or thrown by result().
+ */
+template<typename _RetTy = void>
+class BitTask
+{
+public:
+    struct promise_type : BitTaskResult<_RetTy>
+    {
+        std::coroutine_handle<> continuation_ = std::noop_coroutine();
+        std::exception_ptr error_;
+
+        template<typename... _ArgTy>
+        static void* operator new(std::size_t size, BitCoReader& in, _ArgTy&...);
+
+        static void operator delete(void* ptr)
+        {
+            BitFramePool::deallocate(ptr);
+        }
+
+        BitTask get_return_object()
+        {
+            return BitTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        /* go on with the awaiting routine, if any */
+        auto final_suspend() noexcept
+        {
+            struct Awaiter
+            {
+                bool await_ready() noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept
+                {
+                    return h.promise().continuation_;
+                }
+                void await_resume() noexcept {}
+            };
+            return Awaiter{};
+        }
+
+        void unhandled_exception() { error_ = std::current_exception(); }
+    };
+
+    BitTask() : handle_(nullptr) {}
+    BitTask(BitTask&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+    BitTask& operator=(BitTask&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle_)
+                handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    ~BitTask()
+    {
+        if (handle_)
+            handle_.destroy();
+    }
+
+    /* run the routine until it waits for bits or returns */
+    void start() { handle_.resume(); }
+
+    /* the routine has returned */
+    bool done() const { return handle_ && handle_.done(); }
+
+    /* the value returned by the routine, once done() */
+    _RetTy result()
+    {
+        if (handle_.promise().error_)
+            std::rethrow_exception(handle_.promise().error_);
+        return handle_.promise().take();
+    }
+
+    /* awaiting a routine starts it; the awaiting routine goes on once it returns */
+    auto operator co_await() noexcept
+    {
+        struct Awaiter
+        {
+            std::coroutine_handle<promise_type> handle_;
+
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                handle_.promise().continuation_ = awaiting;
+                return handle_;
+            }
+            _RetTy await_resume()
+            {
+                if (handle_.promise().error_)
+                    std::rethrow_exception(handle_.promise().error_);
+                return handle_.promise().take();
+            }
+        };
+        return Awaiter{ handle_ };
+    }
+
+private:
+    explicit BitTask(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+/********************************************************************
+ * BitCoReader - reads consecutive bitfields of a bitstream which is passed
+ *     in pieces to feed(). as BitReader, the bits are held in a 64-bit
+ *     window aligned to the MSB and topped up by 8-byte loads of the piece;
+ *     a piece is not copied, it is consumed by the routines while feed()
+ *     runs. the bits taken from a piece but not yet read stay in the window
+ *     for the following routines. the reader must outlive the routines, whose
+ *     frames are taken from its pool.
+ */
+class BitCoReader
+{
+public:
+    BitCoReader() : next_(nullptr), end_(nullptr), win_(0), avail_(0), bits_(0), need_(0), waiting_(nullptr) {}
+
+    BitCoReader(const BitCoReader&) = delete;
+    BitCoReader& operator=(const BitCoReader&) = delete;
+
+    /* number of bits read so far */
+    uint64_t bit() const { return bits_; }
+
+    /* number of received bits not read yet, while no routine is waiting */
+    int avail() const { return avail_; }
+
+    /* the frames of the routines reading from this reader */
+    BitFramePool& pool() { return pool_; }
+
+    /* read a bitfield, to be awaited by a routine
+     * len ... length of bitfield (0 - 57)
+     */
+    auto bits(int len)
+    {
+        struct Awaiter
+        {
+            BitCoReader& in_;
+            int len_;
+
+            bool await_ready()
+            {
+                if (in_.avail_ < len_)
+                    in_.refill();
+                return in_.avail_ >= len_;
+            }
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                in_.waiting_ = handle;
+                in_.need_ = len_;
+            }
+            uint64_t await_resume() { return in_.take(len_); }
+        };
+        return Awaiter{ *this, len };
+    }
+
+    /* skip to the following byte boundary of the stream */
+    void align()
+    {
+        (void)take(avail_ & 7);
+    }
+
+    /* pass the following piece of the stream to the waiting routine, which
+     *     runs until it has consumed the piece or returns
+     * buf ... piece of the stream
+     * size .. length of the piece in bytes
+     * returns the number of bytes taken from the piece, fewer than 'size'
+     *     only if no routine waits for bits any longer; the rest is to be
+     *     passed again
+     */
+    std::size_t feed(const void* buf, std::size_t size)
+    {
+        next_ = (const uint8_t*)buf;
+        end_ = next_ + size;
+
+        if (waiting_)
+        {
+            refill();
+            if (avail_ >= need_)
+                std::exchange(waiting_, nullptr).resume();
+        }
+
+        const std::size_t ret = size - (std::size_t)(end_ - next_);
+        next_ = end_ = nullptr;
+        return ret;
+    }
+
+private:
+    /* top the window up to 57 - 64 bits, or to the end of the piece */
+    void refill()
+    {
+        if (end_ - next_ >= 8)
+        {
+            const int bytes = (64 - avail_) >> 3;
+            if (bytes != 0)
+            {
+                win_ |= BYTE_64_LOAD(next_, 0) >> avail_;
+                next_ += bytes;
+                avail_ += bytes << 3;
+                if (avail_ < 64)
+                    win_ &= ~(~(uint64_t)0 >> avail_);
+            }
+        }
+        else
+        {
+            for (; avail_ <= 56 && next_ < end_; avail_ += 8)
+                win_ |= (uint64_t)(*next_++) << (56 - avail_);
+        }
+    }
+
+    uint64_t take(int len)
+    {
+        const uint64_t ret = (len != 0) ? (win_ >> (64 - len)) : 0;
+        win_ = (len < 64) ? (win_ << len) : 0;
+        avail_ -= len;
+        bits_ += len;
+        return ret;
+    }
+
+    const uint8_t* next_;
+    const uint8_t* end_;
+    uint64_t win_;
+    int avail_;
+    uint64_t bits_;
+    int need_;
+    std::coroutine_handle<> waiting_;
+    BitFramePool pool_;
+};
+
+template<typename _RetTy>
+template<typename... _ArgTy>
+inline void* BitTask<_RetTy>::promise_type::operator new(std::size_t size, BitCoReader& in, _ArgTy&...)
+{
+    return in.pool().allocate(size);
+}
+
+#endif /* BIT_HAVE_COROUTINE */
+
+#endif /* __BIT_COROUTINE_H__ */
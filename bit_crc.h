@@ -0,0 +1,219 @@
+/* bit_crc.h
+ * definitions for computing CRCs over ranges of bits which may start and end
+ * at arbitrary bit addresses, e.g. the CRC-24Q of RTCM3 frames, without
+ * copying the range to an aligned buffer first.
+ */
+
+#ifndef __BIT_CRC_H__
+#define __BIT_CRC_H__
+
+#pragma warning(disable : 26451)
+
+#include <cstddef>
+
+/* the CRC-32C instruction of SSE 4.2 on 64-bit operands is available */
+#if (defined(__SSE4_2__) || defined(__AVX__)) && (defined(__x86_64__) || defined(_M_X64))
+#define BIT_HAVE_CRC32C 1
+#include <nmmintrin.h>
+#else
+#define BIT_HAVE_CRC32C 0
+#endif
+
+#include "bit_bits.h"
+
+/********************************************************************
+ * BitCrc - table driven CRC engine of 1 - 32 bits (slicing-by-8).
+ *     the range is processed as consecutive 8-bit values followed by a
+ *     last value of the remaining 1 - 7 bits; a 64-bit window of the
+ *     range is loaded at once, shifted into place when the range is not
+ *     byte aligned. for a reflected CRC every value is consumed LSB first,
+ *     as the bytes of a byte aligned range. the CRC-32C of SSE 4.2 is
+ *     used for the Castagnoli polynomial where available.
+ */
+class BitCrc
+{
+public:
+    /* set up a CRC with the Rocksoft parameters
+     * width ..... width of the CRC (1 - 32)
+     * poly ...... polynomial, without the x^width term
+     * init ...... initial value
+     * reflected . input and output reflected
+     * xorout .... value XORed to the result
+     */
+    BitCrc(int width, uint32_t poly, uint32_t init, bool reflected, uint32_t xorout)
+        : width_(width), reflected_(reflected), xorout_(xorout)
+    {
+        if (reflected)
+        {
+            poly_ = reflect(poly, width);
+            init_ = reflect(init, width);
+            for (uint32_t b = 0; b < 256; ++b)
+            {
+                uint32_t reg = b;
+                for (int i = 0; i < 8; ++i)
+                    reg = (reg & 1) ? ((reg >> 1) ^ poly_) : (reg >> 1);
+                table_[0][b] = reg;
+            }
+            for (int t = 1; t < 8; ++t)
+                for (uint32_t b = 0; b < 256; ++b)
+                    table_[t][b] = (table_[t - 1][b] >> 8) ^ table_[0][table_[t - 1][b] & 0xFF];
+        }
+        else
+        {
+            /* the register is aligned to the MSB of 32 bits */
+            poly_ = poly << (32 - width);
+            init_ = init << (32 - width);
+            for (uint32_t b = 0; b < 256; ++b)
+            {
+                uint32_t reg = b << 24;
+                for (int i = 0; i < 8; ++i)
+                    reg = (reg & 0x80000000) ? ((reg << 1) ^ poly_) : (reg << 1);
+                table_[0][b] = reg;
+            }
+            for (int t = 1; t < 8; ++t)
+                for (uint32_t b = 0; b < 256; ++b)
+                    table_[t][b] = (table_[t - 1][b] << 8) ^ table_[0][table_[t - 1][b] >> 24];
+        }
+
+        hw_crc32c_ = false;
+#if BIT_HAVE_CRC32C
+        hw_crc32c_ = reflected && width == 32 && poly == 0x1EDC6F41;
+#endif
+    }
+
+    int width() const { return width_; }
+
+    /* compute the CRC of a range of bits
+     * buf ... buffer
+     * bit ... bit address of the range
+     * len ... length of the range in bits
+     */
+    uint32_t compute(const void* buf, uint64_t bit, uint64_t len) const
+    {
+        const uint8_t* in = (const uint8_t*)buf + ADDR(bit);
+        const int off = (int)OFFSET(bit);
+        uint32_t reg = init_;
+
+        /* 8 values at a time; the ninth byte belongs to the range if it is
+         *     needed, i.e. if the range is not byte aligned
+         */
+        for (; len >= 64; len -= 64, in += 8)
+        {
+            uint64_t word = BYTE_64_LOAD(in, 0);
+            if (off != 0)
+                word = (word << off) | ((uint64_t)BYTE_8(in, 8) >> (8 - off));
+
+#if BIT_HAVE_CRC32C
+            if (hw_crc32c_)
+            {
+                reg = (uint32_t)_mm_crc32_u64(reg, BYTE_SWAP64(word));
+                continue;
+            }
+#endif
+            reg = reflected_ ? update64_reflected(reg, word) : update64(reg, word);
+        }
+
+        for (; len >= 8; len -= 8, in += 1)
+        {
+            uint64_t val = 0;
+            BIT_BITS(in, off, 8, val);
+            reg = reflected_ ? ((reg >> 8) ^ table_[0][(reg ^ (uint32_t)val) & 0xFF]) : ((reg << 8) ^ table_[0][(reg >> 24) ^ (uint32_t)val]);
+        }
+
+        if (len > 0)
+        {
+            uint64_t val = 0;
+            BIT_BITS(in, off, (int)len, val);
+            if (reflected_)
+            {
+                reg ^= (uint32_t)val;
+                for (uint64_t i = 0; i < len; ++i)
+                    reg = (reg & 1) ? ((reg >> 1) ^ poly_) : (reg >> 1);
+            }
+            else
+            {
+                reg ^= (uint32_t)val << (32 - len);
+                for (uint64_t i = 0; i < len; ++i)
+                    reg = (reg & 0x80000000) ? ((reg << 1) ^ poly_) : (reg << 1);
+            }
+        }
+
+        return (reflected_ ? reg : (reg >> (32 - width_))) ^ xorout_;
+    }
+
+private:
+    static uint32_t reflect(uint32_t val, int width)
+    {
+        uint32_t ret = 0;
+        for (int i = 0; i < width; ++i, val >>= 1)
+            ret = (ret << 1) | (val & 1);
+        return ret;
+    }
+
+    /* consume 8 bytes, the first one in the MSB of 'word' */
+    uint32_t update64(uint32_t reg, uint64_t word) const
+    {
+        uint32_t hi = reg ^ (uint32_t)(word >> 32);
+        uint32_t lo = (uint32_t)word;
+        return table_[7][hi >> 24] ^ table_[6][(hi >> 16) & 0xFF] ^ table_[5][(hi >> 8) & 0xFF] ^ table_[4][hi & 0xFF] ^
+            table_[3][lo >> 24] ^ table_[2][(lo >> 16) & 0xFF] ^ table_[1][(lo >> 8) & 0xFF] ^ table_[0][lo & 0xFF];
+    }
+
+    /* consume 8 bytes of a reflected CRC, the first one in the MSB of 'word' */
+    uint32_t update64_reflected(uint32_t reg, uint64_t word) const
+    {
+        uint64_t le = BYTE_SWAP64(word);
+        uint32_t lo = reg ^ (uint32_t)le;
+        uint32_t hi = (uint32_t)(le >> 32);
+        return table_[7][lo & 0xFF] ^ table_[6][(lo >> 8) & 0xFF] ^ table_[5][(lo >> 16) & 0xFF] ^ table_[4][lo >> 24] ^
+            table_[3][hi & 0xFF] ^ table_[2][(hi >> 8) & 0xFF] ^ table_[1][(hi >> 16) & 0xFF] ^ table_[0][hi >> 24];
+    }
+
+    uint32_t table_[8][256];
+    int width_;
+    bool reflected_;
+    bool hw_crc32c_;
+    uint32_t poly_;
+    uint32_t init_;
+    uint32_t xorout_;
+};
+
+/********************************************************************
+ * Functions for computing common CRCs over ranges of bits; the tables are
+ *     built on the first call
+ */
+
+/* CRC-24Q (RTCM3, Qualcomm): poly 0x864CFB, init 0, not reflected
+ * buf ... buffer
+ * bit ... bit address of the range
+ * len ... length of the range in bits
+ */
+static inline uint32_t crc24q_bits(const void* buf, uint64_t bit, uint64_t len)
+{
+    static const BitCrc crc(24, 0x864CFB, 0, false, 0);
+    return crc.compute(buf, bit, len);
+}
+
+/* CRC-16/CCITT-FALSE: poly 0x1021, init 0xFFFF, not reflected
+ * buf ... buffer
+ * bit ... bit address of the range
+ * len ... length of the range in bits
+ */
+static inline uint16_t crc16_ccitt_bits(const void* buf, uint64_t bit, uint64_t len)
+{
+    static const BitCrc crc(16, 0x1021, 0xFFFF, false, 0);
+    return (uint16_t)crc.compute(buf, bit, len);
+}
+
+/* CRC-32C (Castagnoli): poly 0x1EDC6F41, init and xorout 0xFFFFFFFF, reflected
+ * buf ... buffer
+ * bit ... bit address of the range
+ * len ... length of the range in bits
+ */
+static inline uint32_t crc32c_bits(const void* buf, uint64_t bit, uint64_t len)
+{
+    static const BitCrc crc(32, 0x1EDC6F41, 0xFFFFFFFF, true, 0xFFFFFFFF);
+    return crc.compute(buf, bit, len);
+}
+
+#endif /* __BIT_CRC_H__ */
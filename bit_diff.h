@@ -0,0 +1,216 @@
+/* bit_diff.h
+ * definitions for comparing two ranges of bits which may start at different,
+ * arbitrary bit addresses: the first differing bit and the number of
+ * differing bits.
+ */
+
+#ifndef __BIT_DIFF_H__
+#define __BIT_DIFF_H__
+
+#pragma warning(disable : 26451)
+
+#include <cstddef>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "bit_bits.h"
+#include "bit_extract.h"
+
+/********************************************************************
+ * utility functions for comparing ranges of bits.
+ *     the range of 'a' is aligned to a byte first, then both ranges are
+ *     compared as 64-bit words: a word of 'a' is a plain load, the word of
+ *     'b' is the funnel shift of its 8 bytes and the following byte, which
+ *     belongs to the range whenever it is needed. the ranges are compared
+ *     a block of 4 (AVX2) or 8 (AVX-512) words at a time; nothing past the
+ *     ranges is read.
+ */
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+#define BIT_DIFF_BLOCK 8
+#elif defined(__AVX2__)
+#define BIT_DIFF_BLOCK 4
+#else
+#define BIT_DIFF_BLOCK 1
+#endif
+
+/* XOR a block of BIT_DIFF_BLOCK words of two ranges
+ * a ..... byte aligned range
+ * b ..... range
+ * off ... bit offset of 'b'
+ * x ..... result words
+ * returns true if any result word is not zero
+ */
+static inline bool bit_diff_block(const uint8_t* a, const uint8_t* b, int off, uint64_t* x)
+{
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+    const __m512i bswap = _mm512_set_epi64(
+        0x08090a0b0c0d0e0fLL, 0x0001020304050607LL, 0x08090a0b0c0d0e0fLL, 0x0001020304050607LL,
+        0x08090a0b0c0d0e0fLL, 0x0001020304050607LL, 0x08090a0b0c0d0e0fLL, 0x0001020304050607LL);
+
+    __m512i wa = _mm512_shuffle_epi8(_mm512_loadu_si512((const void*)a), bswap);
+    __m512i wb = _mm512_shuffle_epi8(_mm512_loadu_si512((const void*)b), bswap);
+    if (off != 0)
+    {
+        __m512i next = _mm512_shuffle_epi8(_mm512_loadu_si512((const void*)(b + 1)), bswap);
+        wb = _mm512_or_si512(_mm512_sll_epi64(wb, _mm_cvtsi32_si128(off)), _mm512_srl_epi64(next, _mm_cvtsi32_si128(8 - off)));
+    }
+    __m512i diff = _mm512_xor_si512(wa, wb);
+    _mm512_storeu_si512((void*)x, diff);
+    return _mm512_test_epi64_mask(diff, diff) != 0;
+#elif defined(__AVX2__)
+    const __m256i bswap = _mm256_set_epi64x(
+        0x08090a0b0c0d0e0fLL, 0x0001020304050607LL, 0x08090a0b0c0d0e0fLL, 0x0001020304050607LL);
+
+    __m256i wa = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)a), bswap);
+    __m256i wb = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)b), bswap);
+    if (off != 0)
+    {
+        __m256i next = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(b + 1)), bswap);
+        wb = _mm256_or_si256(_mm256_sll_epi64(wb, _mm_cvtsi32_si128(off)), _mm256_srl_epi64(next, _mm_cvtsi32_si128(8 - off)));
+    }
+    __m256i diff = _mm256_xor_si256(wa, wb);
+    _mm256_storeu_si256((__m256i*)x, diff);
+    return _mm256_testz_si256(diff, diff) == 0;
+#else
+    uint64_t wb = BYTE_64_LOAD(b, 0);
+    if (off != 0)
+        wb = (wb << off) | ((uint64_t)BYTE_8(b, 8) >> (8 - off));
+    x[0] = BYTE_64_LOAD(a, 0) ^ wb;
+    return x[0] != 0;
+#endif
+}
+
+/********************************************************************
+ * Functions for comparing ranges of bits
+ */
+
+/* find the first differing bit of two ranges of bits
+ * a ..... first buffer
+ * a_bit . bit address of the range in 'a'
+ * b ..... second buffer
+ * b_bit . bit address of the range in 'b'
+ * len ... length of the ranges in bits
+ * returns the index of the first differing bit in the ranges, counted from
+ *     the first bit, or 'len' if the ranges are equal
+ */
+static inline uint64_t first_diff_bit(const void* a, uint64_t a_bit, const void* b, uint64_t b_bit, uint64_t len)
+{
+    const uint8_t* pa = (const uint8_t*)a;
+    const uint8_t* pb = (const uint8_t*)b;
+    uint64_t done = 0;
+
+    /* the head bits up to the first byte boundary of 'a' */
+    if (OFFSET(a_bit) != 0 && len != 0)
+    {
+        const int head = (BIT_IN_FIRST(a_bit) < len) ? (int)BIT_IN_FIRST(a_bit) : (int)len;
+        uint64_t va = 0, vb = 0;
+        BIT_BITS(pa, a_bit, head, va);
+        BIT_BITS(pb, b_bit, head, vb);
+        if (va != vb)
+            return bit_clz64(va ^ vb) - (64 - head);
+        done = head;
+    }
+
+    pa += ADDR(a_bit + done);
+    pb += ADDR(b_bit + done);
+    const int off = (int)OFFSET(b_bit + done);
+    uint64_t x[BIT_DIFF_BLOCK];
+
+    for (; len - done >= 64 * BIT_DIFF_BLOCK; done += 64 * BIT_DIFF_BLOCK, pa += 8 * BIT_DIFF_BLOCK, pb += 8 * BIT_DIFF_BLOCK)
+    {
+        if (bit_diff_block(pa, pb, off, x))
+        {
+            int i = 0;
+            while (x[i] == 0)
+                ++i;
+            return done + 64 * i + bit_clz64(x[i]);
+        }
+    }
+
+    for (; len - done >= 64; done += 64, pa += 8, pb += 8)
+    {
+        uint64_t wb = BYTE_64_LOAD(pb, 0);
+        if (off != 0)
+            wb = (wb << off) | ((uint64_t)BYTE_8(pb, 8) >> (8 - off));
+        if (BYTE_64_LOAD(pa, 0) != wb)
+            return done + bit_clz64(BYTE_64_LOAD(pa, 0) ^ wb);
+    }
+
+    /* the last 0 - 63 bits */
+    if (len > done)
+    {
+        const int tail = (int)(len - done);
+        uint64_t va = 0, vb = 0;
+        BIT_BITS(pa, 0, tail, va);
+        BIT_BITS(pb, off, tail, vb);
+        if (va != vb)
+            return done + bit_clz64(va ^ vb) - (64 - tail);
+    }
+
+    return len;
+}
+
+/* count the differing bits of two ranges of bits
+ * a ..... first buffer
+ * a_bit . bit address of the range in 'a'
+ * b ..... second buffer
+ * b_bit . bit address of the range in 'b'
+ * len ... length of the ranges in bits
+ */
+static inline uint64_t count_diff_bits(const void* a, uint64_t a_bit, const void* b, uint64_t b_bit, uint64_t len)
+{
+    const uint8_t* pa = (const uint8_t*)a;
+    const uint8_t* pb = (const uint8_t*)b;
+    uint64_t done = 0;
+    uint64_t count = 0;
+
+    /* the head bits up to the first byte boundary of 'a' */
+    if (OFFSET(a_bit) != 0 && len != 0)
+    {
+        const int head = (BIT_IN_FIRST(a_bit) < len) ? (int)BIT_IN_FIRST(a_bit) : (int)len;
+        uint64_t va = 0, vb = 0;
+        BIT_BITS(pa, a_bit, head, va);
+        BIT_BITS(pb, b_bit, head, vb);
+        count += bit_popcount64(va ^ vb);
+        done = head;
+    }
+
+    pa += ADDR(a_bit + done);
+    pb += ADDR(b_bit + done);
+    const int off = (int)OFFSET(b_bit + done);
+    uint64_t x[BIT_DIFF_BLOCK];
+
+    for (; len - done >= 64 * BIT_DIFF_BLOCK; done += 64 * BIT_DIFF_BLOCK, pa += 8 * BIT_DIFF_BLOCK, pb += 8 * BIT_DIFF_BLOCK)
+    {
+        if (bit_diff_block(pa, pb, off, x))
+        {
+            for (int i = 0; i < BIT_DIFF_BLOCK; ++i)
+                count += bit_popcount64(x[i]);
+        }
+    }
+
+    for (; len - done >= 64; done += 64, pa += 8, pb += 8)
+    {
+        uint64_t wb = BYTE_64_LOAD(pb, 0);
+        if (off != 0)
+            wb = (wb << off) | ((uint64_t)BYTE_8(pb, 8) >> (8 - off));
+        count += bit_popcount64(BYTE_64_LOAD(pa, 0) ^ wb);
+    }
+
+    /* the last 0 - 63 bits */
+    if (len > done)
+    {
+        const int tail = (int)(len - done);
+        uint64_t va = 0, vb = 0;
+        BIT_BITS(pa, 0, tail, va);
+        BIT_BITS(pb, off, tail, vb);
+        count += bit_popcount64(va ^ vb);
+    }
+
+    return count;
+}
+
+#endif /* __BIT_DIFF_H__ */
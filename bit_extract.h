@@ -0,0 +1,228 @@
+/* bit_extract.h
+ * definitions for extracting and depositing the bits selected by a mask,
+ * which may be non-contiguous, and for splitting a word into several fields.
+ */
+
+#ifndef __BIT_EXTRACT_H__
+#define __BIT_EXTRACT_H__
+
+#pragma warning(disable : 26451)
+
+#include <cstddef>
+
+#include "bit_bits.h"
+
+/* BMI2 (PEXT/PDEP) is available; MSVC does not define __BMI2__, but every
+ *     CPU with AVX2 has BMI2
+ */
+#if defined(__BMI2__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define BIT_HAVE_BMI2 1
+#include <immintrin.h>
+#else
+#define BIT_HAVE_BMI2 0
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+/********************************************************************
+ * utility functions for parallel bit extract and deposit on 64-bit words
+ */
+
+/* gather the bits of 'val' selected by 'mask' to the low bits of the result;
+ *     PEXT on BMI2, otherwise a loop over the set bits of 'mask'
+ * val ... source word
+ * mask .. bits to extract
+ */
+static inline uint64_t bit_pext64(uint64_t val, uint64_t mask)
+{
+#if BIT_HAVE_BMI2
+    return (uint64_t)_pext_u64(val, mask);
+#else
+    uint64_t ret = 0;
+    for (uint64_t bb = 1; mask != 0; bb += bb)
+    {
+        if (val & mask & (0 - mask))
+            ret |= bb;
+        mask &= mask - 1;
+    }
+    return ret;
+#endif
+}
+
+/* scatter the low bits of 'val' to the bits selected by 'mask';
+ *     PDEP on BMI2, otherwise a loop over the set bits of 'mask'
+ * val ... source word
+ * mask .. bits to deposit to
+ */
+static inline uint64_t bit_pdep64(uint64_t val, uint64_t mask)
+{
+#if BIT_HAVE_BMI2
+    return (uint64_t)_pdep_u64(val, mask);
+#else
+    uint64_t ret = 0;
+    for (uint64_t bb = 1; mask != 0; bb += bb)
+    {
+        if (val & bb)
+            ret |= mask & (0 - mask);
+        mask &= mask - 1;
+    }
+    return ret;
+#endif
+}
+
+/* count the set bits of a long long (64 bit) */
+static inline int bit_popcount64(uint64_t val)
+{
+#if defined(_MSC_VER) && defined(__AVX__)
+    return (int)__popcnt64(val);
+#elif defined(__GNUC__)
+    return __builtin_popcountll(val);
+#else
+    val = val - ((val >> 1) & 0x5555555555555555ULL);
+    val = (val & 0x3333333333333333ULL) + ((val >> 2) & 0x3333333333333333ULL);
+    val = (val + (val >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((val * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/* count the trailing zero bits of a non-zero long long (64 bit) */
+static inline int bit_ctz64(uint64_t val)
+{
+#if defined(_MSC_VER)
+    unsigned long idx;
+    (void)_BitScanForward64(&idx, val);
+    return (int)idx;
+#else
+    return __builtin_ctzll(val);
+#endif
+}
+
+/* count the leading zero bits of a non-zero long long (64 bit) */
+static inline int bit_clz64(uint64_t val)
+{
+#if defined(_MSC_VER)
+    unsigned long idx;
+    (void)_BitScanReverse64(&idx, val);
+    return 63 - (int)idx;
+#else
+    return __builtin_clzll(val);
+#endif
+}
+
+/* find the position (from the LSB) of the set bit 'idx' (0 - popcount - 1)
+ *     of a long long (64 bit); PDEP on BMI2, otherwise broadword: the byte
+ *     holding the bit is found by comparing the cumulative popcounts of the
+ *     bytes with 'idx' in parallel, the bit within the byte by spreading its
+ *     bits to the bytes of a word and doing the same
+ */
+static inline int bit_select64(uint64_t val, int idx)
+{
+#if BIT_HAVE_BMI2
+    return bit_ctz64(bit_pdep64((uint64_t)1 << idx, val));
+#else
+    const uint64_t l8 = 0x0101010101010101ULL, h8 = 0x8080808080808080ULL;
+
+    /* the popcount of bytes 0 - i in byte i; the number of bytes whose
+     *     count is at most 'idx' is the byte holding the bit
+     */
+    uint64_t cnt = val - ((val >> 1) & 0x5555555555555555ULL);
+    cnt = (cnt & 0x3333333333333333ULL) + ((cnt >> 2) & 0x3333333333333333ULL);
+    cnt = ((cnt + (cnt >> 4)) & 0x0F0F0F0F0F0F0F0FULL) * l8;
+    const int byte = (int)((((((((uint64_t)idx * l8) | h8) - cnt) & h8) >> 7) * l8) >> 56) << 3;
+    const int rank = idx - (int)(((cnt << 8) >> byte) & 0xFF);
+
+    /* the bits of the byte as 0 or 1 in the bytes of a word, likewise */
+    const uint64_t bits = ((((val >> byte) & 0xFF) * l8) & 0x8040201008040201ULL) + 0x7F7F7F7F7F7F7F7FULL;
+    const uint64_t ones = ((bits & h8) >> 7) * l8;
+    return byte + (int)((((((((uint64_t)rank * l8) | h8) - ones) & h8) >> 7) * l8) >> 56);
+#endif
+}
+
+/********************************************************************
+ * Functions for extracting and depositing masked bits of a bitfield.
+ *     the mask applies to the bitfield as returned by BIT_BITS, i.e. its
+ *     LSB is the last bit of the bitfield
+ */
+
+/* extract the bits selected by 'mask' of a bitfield with custom length up to
+ *     64 bits, packed to the low bits of the result
+ * buf ... buffer
+ * bit ... bit address
+ * len ... length of bitfield
+ * mask .. bits of the bitfield to extract
+ */
+template<typename _BufTy, typename _BitTy, typename _LenTy>
+static inline uint64_t bits_extract(_BufTy buf, _BitTy bit, _LenTy len, uint64_t mask)
+{
+    uint64_t field = 0;
+    BIT_BITS(buf, bit, len, field);
+    return bit_pext64(field, mask);
+}
+
+/* deposit the low bits of 'val' to the bits selected by 'mask' of a bitfield
+ *     with custom length up to 64 bits; the other bits of the bitfield are kept
+ * buf ... buffer
+ * bit ... bit address
+ * len ... length of bitfield
+ * mask .. bits of the bitfield to write
+ * val ... value to write
+ */
+template<typename _BufTy, typename _BitTy, typename _LenTy>
+static inline void bits_deposit(_BufTy buf, _BitTy bit, _LenTy len, uint64_t mask, uint64_t val)
+{
+    uint64_t field = 0;
+    BIT_BITS(buf, bit, len, field);
+    field = (field & ~mask) | bit_pdep64(val, mask);
+    BIT_WBITS(buf, bit, len, field);
+}
+
+/********************************************************************
+ * Functions for splitting a bitfield into several consecutive fields
+ */
+
+/* extract 'k' consecutive bitfields with lengths 'lens' (in total up to 64
+ *     bits) by a single load of the whole range
+ * buf ... buffer
+ * bit ... bit address of the first bitfield
+ * lens .. lengths of the bitfields
+ * k ..... number of bitfields
+ * out ... result array
+ */
+template<typename _BufTy, typename _BitTy>
+static inline void bits_split(_BufTy buf, _BitTy bit, const uint8_t* lens, std::size_t k, uint64_t* out)
+{
+    int total = 0;
+    for (std::size_t i = 0; i < k; ++i)
+        total += lens[i];
+
+    /* align the range to the MSB and shift the fields out one by one; fields
+     *     of length 0 are 0, as are all of them if the range is empty
+     */
+    uint64_t word = 0;
+    if (total != 0)
+    {
+        BIT_BITS(buf, bit, total, word);
+        word <<= (64 - total);
+    }
+    for (std::size_t i = 0; i < k; ++i)
+    {
+        out[i] = (lens[i] != 0) ? (word >> (64 - lens[i])) : 0;
+        word = (lens[i] < 64) ? (word << lens[i]) : 0;
+    }
+}
+
+/* extract 'k' consecutive bitfields with lengths 'lens' (in total up to 64
+ *     bits) by a single load of the whole range
+ * buf ... buffer
+ * bit ... bit address of the first bitfield
+ * lens .. lengths of the bitfields
+ * out ... result array
+ */
+template<std::size_t _K, typename _BufTy, typename _BitTy>
+static inline void bits_split(_BufTy buf, _BitTy bit, const uint8_t (&lens)[_K], uint64_t (&out)[_K])
+{
+    bits_split(buf, bit, lens, _K, out);
+}
+
+#endif /* __BIT_EXTRACT_H__ */
@@ -0,0 +1,215 @@
+/* bit_gather.h
+ * definitions for extracting many bitfields at arbitrary bit addresses of a
+ * padded buffer in one call, with AVX2/AVX-512 gathers where available.
+ */
+
+#ifndef __BIT_GATHER_H__
+#define __BIT_GATHER_H__
+
+#pragma warning(disable : 26451)
+
+#include <cstddef>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "bit_bits.h"
+
+/********************************************************************
+ * utility functions for gathering bitfields.
+ *     a field is read as the 64-bit window starting at its bit address:
+ *     the 8 bytes at ADDR(bit) shifted left by OFFSET(bit), completed by
+ *     the byte at ADDR(bit) + 8, then shifted right by (64 - len). this is
+ *     branch-free for every length up to 64 bits and never reads past the
+ *     BYTE_PADDING bytes following the byte holding the last bit.
+ */
+
+/* extract bitfield with custom length up to 64 bits from a padded buffer
+ *     without branches
+ * buf ... buffer
+ * adr ... byte address of the bitfield, ADDR(bit)
+ * off ... bit offset of the bitfield, OFFSET(bit)
+ * rsh ... 64 - length of bitfield
+ */
+#define BIT_GATHER_ONE(buf,adr,off,rsh) \
+    (((BYTE_64_LOAD(buf, adr) << (off)) | ((uint64_t)BYTE_8(buf, (adr) + 8) >> (8 - (off)))) >> (rsh))
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+
+/* extract 8 bitfields by two 8-lane gathers
+ * buf ... padded buffer
+ * adr ... byte addresses of the bitfields (8 x int32)
+ * off ... bit offsets of the bitfields (8 x int64)
+ * rsh ... 64 - lengths of bitfields (8 x int64)
+ */
+static inline __m512i bit_gather_x8(const uint8_t* buf, __m256i adr, __m512i off, __m512i rsh)
+{
+    const __m512i bswap = _mm512_set_epi64(
+        0x08090a0b0c0d0e0fLL, 0x0001020304050607LL, 0x08090a0b0c0d0e0fLL, 0x0001020304050607LL,
+        0x08090a0b0c0d0e0fLL, 0x0001020304050607LL, 0x08090a0b0c0d0e0fLL, 0x0001020304050607LL);
+
+    __m512i head = _mm512_shuffle_epi8(_mm512_i32gather_epi64(adr, (const void*)buf, 1), bswap);
+    __m512i next = _mm512_shuffle_epi8(_mm512_i32gather_epi64(adr, (const void*)(buf + 1), 1), bswap);
+    __m512i win = _mm512_or_si512(_mm512_sllv_epi64(head, off),
+        _mm512_srlv_epi64(next, _mm512_sub_epi64(_mm512_set1_epi64(8), off)));
+    return _mm512_srlv_epi64(win, rsh);
+}
+
+#elif defined(__AVX2__)
+
+/* extract 4 bitfields by two 4-lane gathers
+ * buf ... padded buffer
+ * adr ... byte addresses of the bitfields (4 x int32)
+ * off ... bit offsets of the bitfields (4 x int64)
+ * rsh ... 64 - lengths of bitfields (4 x int64)
+ */
+static inline __m256i bit_gather_x4(const uint8_t* buf, __m128i adr, __m256i off, __m256i rsh)
+{
+    const __m256i bswap = _mm256_set_epi64x(
+        0x08090a0b0c0d0e0fLL, 0x0001020304050607LL, 0x08090a0b0c0d0e0fLL, 0x0001020304050607LL);
+
+    __m256i head = _mm256_shuffle_epi8(_mm256_i32gather_epi64((const long long*)buf, adr, 1), bswap);
+    __m256i next = _mm256_shuffle_epi8(_mm256_i32gather_epi64((const long long*)(buf + 1), adr, 1), bswap);
+    __m256i win = _mm256_or_si256(_mm256_sllv_epi64(head, off),
+        _mm256_srlv_epi64(next, _mm256_sub_epi64(_mm256_set1_epi64x(8), off)));
+    return _mm256_srlv_epi64(win, rsh);
+}
+
+#endif
+
+/********************************************************************
+ * Functions for gathering bitfields at arbitrary bit addresses of a padded
+ *     buffer; lengths are 1 - 64 bits, bit addresses below 2^32
+ */
+
+/* extract 'n' bitfields at bit addresses 'bit_offsets' with lengths 'lens'
+ * buf ......... padded buffer
+ * bit_offsets . bit addresses of the bitfields
+ * lens ........ lengths of the bitfields
+ * n ........... number of bitfields
+ * out ......... result array
+ */
+static inline void gather_bits(const void* buf, const uint32_t* bit_offsets, const uint8_t* lens, std::size_t n, uint64_t* out)
+{
+    const uint8_t* src = (const uint8_t*)buf;
+    std::size_t i = 0;
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i bit = _mm256_loadu_si256((const __m256i*)(bit_offsets + i));
+        __m512i off = _mm512_cvtepu32_epi64(_mm256_and_si256(bit, _mm256_set1_epi32(0x07)));
+        __m512i len = _mm512_cvtepu8_epi64(_mm_loadl_epi64((const __m128i*)(lens + i)));
+        __m512i ret = bit_gather_x8(src, _mm256_srli_epi32(bit, 3), off, _mm512_sub_epi64(_mm512_set1_epi64(64), len));
+        _mm512_storeu_si512((void*)(out + i), ret);
+    }
+#elif defined(__AVX2__)
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i bit = _mm_loadu_si128((const __m128i*)(bit_offsets + i));
+        __m256i off = _mm256_cvtepu32_epi64(_mm_and_si128(bit, _mm_set1_epi32(0x07)));
+        int len4;
+        (void)memcpy(&len4, lens + i, 4);
+        __m256i len = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(len4));
+        __m256i ret = bit_gather_x4(src, _mm_srli_epi32(bit, 3), off, _mm256_sub_epi64(_mm256_set1_epi64x(64), len));
+        _mm256_storeu_si256((__m256i*)(out + i), ret);
+    }
+#endif
+
+    for (; i < n; ++i)
+    {
+        uint32_t bit = bit_offsets[i];
+        out[i] = BIT_GATHER_ONE(src, ADDR(bit), OFFSET(bit), 64 - lens[i]);
+    }
+}
+
+/********************************************************************
+ * BitGatherPlan - precompiled layout of bitfields to gather, to be reused
+ *     for every message with the same layout. the byte addresses, offsets
+ *     and shift counts are resolved once and stored in the form the
+ *     kernels consume, so running the plan only loads, shifts and stores.
+ */
+class BitGatherPlan
+{
+public:
+    BitGatherPlan() {}
+
+    /* compile the layout of 'n' bitfields
+     * bit_offsets . bit addresses of the bitfields
+     * lens ........ lengths of the bitfields (1 - 64)
+     * n ........... number of bitfields
+     */
+    BitGatherPlan(const uint32_t* bit_offsets, const uint8_t* lens, std::size_t n)
+        : adr_(n), off_(n), rsh_(n)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            adr_[i] = (int32_t)ADDR(bit_offsets[i]);
+            off_[i] = OFFSET(bit_offsets[i]);
+            rsh_[i] = 64 - lens[i];
+        }
+    }
+
+    std::size_t size() const { return adr_.size(); }
+
+    /* extract all bitfields of the plan from a padded buffer
+     * buf ... padded buffer
+     * out ... result array with 'size()' elements
+     */
+    void run(const void* buf, uint64_t* out) const
+    {
+        const uint8_t* src = (const uint8_t*)buf;
+        const std::size_t n = adr_.size();
+        std::size_t i = 0;
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+        for (; i + 8 <= n; i += 8)
+        {
+            __m512i ret = bit_gather_x8(src, _mm256_loadu_si256((const __m256i*)(adr_.data() + i)),
+                _mm512_loadu_si512((const void*)(off_.data() + i)), _mm512_loadu_si512((const void*)(rsh_.data() + i)));
+            _mm512_storeu_si512((void*)(out + i), ret);
+        }
+#elif defined(__AVX2__)
+        for (; i + 4 <= n; i += 4)
+        {
+            __m256i ret = bit_gather_x4(src, _mm_loadu_si128((const __m128i*)(adr_.data() + i)),
+                _mm256_loadu_si256((const __m256i*)(off_.data() + i)), _mm256_loadu_si256((const __m256i*)(rsh_.data() + i)));
+            _mm256_storeu_si256((__m256i*)(out + i), ret);
+        }
+#endif
+
+        for (; i < n; ++i)
+            out[i] = BIT_GATHER_ONE(src, adr_[i], off_[i], rsh_[i]);
+    }
+
+    /* extract all bitfields of the plan from 'count' padded messages
+     * buf ... first padded message
+     * stride  distance of consecutive messages in bytes
+     * count . number of messages
+     * out ... result array with 'size() * count' elements, message by message
+     */
+    void run_batch(const void* buf, std::size_t stride, std::size_t count, uint64_t* out) const
+    {
+        for (std::size_t msg = 0; msg < count; ++msg)
+            run((const uint8_t*)buf + msg * stride, out + msg * adr_.size());
+    }
+
+private:
+    std::vector<int32_t> adr_;
+    std::vector<uint64_t> off_;
+    std::vector<uint64_t> rsh_;
+};
+
+/* extract all bitfields of a precompiled plan
+ * buf ... padded buffer
+ * plan .. layout of bitfields
+ * out ... result array with 'plan.size()' elements
+ */
+static inline void gather_bits(const void* buf, const BitGatherPlan& plan, uint64_t* out)
+{
+    plan.run(buf, out);
+}
+
+#endif /* __BIT_GATHER_H__ */
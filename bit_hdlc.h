@@ -0,0 +1,276 @@
+/* bit_hdlc.h
+ * definitions for HDLC bit stuffing: a zero is inserted after every five
+ * consecutive ones of the frame contents, so that the contents never contain
+ * the flag (01111110) or an abort (seven ones).
+ */
+
+#ifndef __BIT_HDLC_H__
+#define __BIT_HDLC_H__
+
+#pragma warning(disable : 26451)
+
+#include <cstddef>
+
+#include "bit_bits.h"
+#include "bit_stream.h"
+
+/********************************************************************
+ * utility functions for bit stuffing.
+ *     the bits are processed a byte at a time by tables indexed by the
+ *     carried state and the byte; the state is the number of consecutive
+ *     ones at the end of the processed bits. an entry holds the output
+ *     bits, their length, the next state and, for unstuffing, the event
+ *     ending the byte early.
+ *
+ *     stuffing entry:   bits 0 - 15 output, 16 - 19 output length,
+ *                       24 - 26 next state (0 - 4 ones)
+ *     unstuffing entry: bits 0 - 7 output, 8 - 11 output length,
+ *                       12 - 15 next state, 16 - 19 bits consumed,
+ *                       20 - 21 event, 24 - 27 bits to take back
+ *     unstuffing state: bits 0 - 2 consecutive ones (6: six ones, the
+ *                       next bit decides between flag and abort; 7: in
+ *                       an abort), bit 3 the zero before the ones was
+ *                       written to the output
+ */
+
+/* the event ending an unstuffed range */
+enum HdlcEvent
+{
+    HDLC_END,       /* end of the input */
+    HDLC_FLAG,      /* a flag, 01111110 */
+    HDLC_ABORT      /* an abort, seven ones */
+};
+
+/* stuff the first 'n' (1 - 8) bits of 'bits', MSB first */
+static inline uint32_t hdlc_stuff_bits(uint32_t state, uint32_t bits, int n)
+{
+    uint32_t out = 0, len = 0;
+    for (int i = n - 1; i >= 0; --i)
+    {
+        const uint32_t b = (bits >> i) & 1;
+        out = (out << 1) | b;
+        ++len;
+        state = b ? (state + 1) : 0;
+        if (state == 5)
+        {
+            out <<= 1;
+            ++len;
+            state = 0;
+        }
+    }
+    return out | (len << 16) | (state << 24);
+}
+
+/* unstuff the first 'n' (1 - 8) bits of 'bits', MSB first, up to an event */
+static inline uint32_t hdlc_unstuff_bits(uint32_t state, uint32_t bits, int n)
+{
+    uint32_t ones = state & 7, zero = state >> 3;
+    uint32_t out = 0, len = 0, event = HDLC_END, retract = 0;
+    int i = 0;
+    while (i < n)
+    {
+        const uint32_t b = (bits >> (n - 1 - i)) & 1;
+        ++i;
+        if (ones == 6)
+        {
+            /* a flag ends the run, an abort goes on until a zero */
+            event = b ? HDLC_ABORT : HDLC_FLAG;
+            retract = 5 + zero;
+            ones = b ? 7 : 0;
+            zero = 0;
+            break;
+        }
+        if (ones == 7)
+        {
+            if (b == 0)
+                ones = 0;
+            continue;
+        }
+
+        if (b)
+        {
+            if (++ones <= 5)
+            {
+                out = (out << 1) | 1;
+                ++len;
+            }
+        }
+        else
+        {
+            /* a zero after five ones was stuffed */
+            zero = (ones != 5);
+            if (zero)
+            {
+                out <<= 1;
+                ++len;
+            }
+            ones = 0;
+        }
+    }
+    return out | (len << 8) | ((ones | (zero << 3)) << 12) | ((uint32_t)i << 16) | (event << 20) | (retract << 24);
+}
+
+/* tables of bit stuffing, built on the first call */
+struct HdlcTables
+{
+    uint32_t stuff[5][256];
+    uint32_t unstuff[16][256];
+
+    HdlcTables()
+    {
+        for (uint32_t b = 0; b < 256; ++b)
+        {
+            for (uint32_t s = 0; s < 5; ++s)
+                stuff[s][b] = hdlc_stuff_bits(s, b, 8);
+            for (uint32_t s = 0; s < 16; ++s)
+                unstuff[s][b] = hdlc_unstuff_bits(s, b, 8);
+        }
+    }
+};
+
+static inline const HdlcTables& hdlc_tables()
+{
+    static const HdlcTables tables;
+    return tables;
+}
+
+/********************************************************************
+ * HdlcStuffer - stuffs the contents of frames; the state is carried from
+ *     call to call, so the contents may be passed in pieces.
+ */
+class HdlcStuffer
+{
+public:
+    HdlcStuffer() : state_(0) {}
+
+    /* stuff a range of bits
+     * src ... source buffer
+     * bit ... bit address of the range
+     * len ... length of the range in bits
+     * out ... output
+     */
+    void stuff(const void* src, uint64_t bit, uint64_t len, BitWriter& out)
+    {
+        const HdlcTables& t = hdlc_tables();
+        uint32_t state = state_;
+
+        /* 8 bytes per load (never past the byte holding the last bit) */
+        while (len >= 8)
+        {
+            const int n = (len < 64) ? (int)(len & ~(uint64_t)7) : 64;
+            uint64_t win = 0;
+            BIT_BITS(src, bit, n, win);
+            win <<= (64 - n);
+            for (int i = 0; i < n; i += 8, win <<= 8)
+            {
+                const uint32_t e = t.stuff[state][win >> 56];
+                out.put(e & 0xFFFF, (e >> 16) & 0x0F);
+                state = e >> 24;
+            }
+            bit += n;
+            len -= n;
+        }
+
+        if (len > 0)
+        {
+            uint32_t tail = 0;
+            BIT_BITS(src, bit, (int)len, tail);
+            const uint32_t e = hdlc_stuff_bits(state, tail, (int)len);
+            out.put(e & 0xFFFF, (e >> 16) & 0x0F);
+            state = e >> 24;
+        }
+
+        state_ = state;
+    }
+
+    /* write a flag, which ends a frame and starts the next one */
+    void flag(BitWriter& out)
+    {
+        out.put(0x7E, 8);
+        state_ = 0;
+    }
+
+private:
+    uint32_t state_;
+};
+
+/********************************************************************
+ * HdlcUnstuffer - removes the stuffed zeros of a bitstream and finds the
+ *     flags and aborts; the state is carried from call to call, so the
+ *     stream may be passed in pieces. the bits of a flag or an abort,
+ *     i.e. the zero and the five ones written before it was recognized,
+ *     are taken back from the output, so at a flag the output ends with
+ *     the contents of the frame.
+ */
+class HdlcUnstuffer
+{
+public:
+    HdlcUnstuffer() : state_(0) {}
+
+    /* unstuff a range of bits up to the first flag or abort
+     * src ... source buffer
+     * bit ... bit address of the range
+     * len ... length of the range in bits
+     * out ... output
+     * used .. number of bits consumed, up to the end of the flag or the
+     *         seventh one of an abort
+     * returns the event ending the call
+     */
+    HdlcEvent unstuff(const void* src, uint64_t bit, uint64_t len, BitWriter& out, uint64_t& used)
+    {
+        const HdlcTables& t = hdlc_tables();
+        uint32_t state = state_;
+        uint64_t done = 0;
+        uint32_t e = 0;
+
+        while (len - done >= 8)
+        {
+            const int n = (len - done < 64) ? (int)((len - done) & ~(uint64_t)7) : 64;
+            uint64_t win = 0;
+            BIT_BITS(src, bit + done, n, win);
+            win <<= (64 - n);
+            for (int i = 0; i < n; i += 8, win <<= 8)
+            {
+                e = t.unstuff[state][win >> 56];
+                out.put(e & 0xFF, (e >> 8) & 0x0F);
+                state = (e >> 12) & 0x0F;
+                if ((e >> 20) & 0x03)
+                {
+                    used = done + i + ((e >> 16) & 0x0F);
+                    return event(e, state, out);
+                }
+            }
+            done += n;
+        }
+
+        if (len > done)
+        {
+            uint32_t tail = 0;
+            BIT_BITS(src, bit + done, (int)(len - done), tail);
+            e = hdlc_unstuff_bits(state, tail, (int)(len - done));
+            out.put(e & 0xFF, (e >> 8) & 0x0F);
+            state = (e >> 12) & 0x0F;
+            if ((e >> 20) & 0x03)
+            {
+                used = done + ((e >> 16) & 0x0F);
+                return event(e, state, out);
+            }
+        }
+
+        state_ = state;
+        used = len;
+        return HDLC_END;
+    }
+
+private:
+    HdlcEvent event(uint32_t e, uint32_t state, BitWriter& out)
+    {
+        out.unput((e >> 24) & 0x0F);
+        state_ = state;
+        return (HdlcEvent)((e >> 20) & 0x03);
+    }
+
+    uint32_t state_;
+};
+
+#endif /* __BIT_HDLC_H__ */
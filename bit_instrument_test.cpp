@@ -0,0 +1,90 @@
+// the instrumentation hooks of bit_bits.h, which expand to calls of the
+// bit_stats.h counters only in a translation unit defining BIT_INSTRUMENT
+#define BIT_INSTRUMENT
+
+#include <stdint.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "bit_bits.h"
+
+// the counters of a thread after a fixed sequence of bitfield calls
+static bool bit_instrument_calls(BitStats& local)
+{
+	uint8_t buf[40], dst[40];
+	for (int i = 0; i < 40; ++i)
+		buf[i] = (uint8_t)(i * 37 + 11);
+	memset(dst, 0, sizeof(dst));
+
+	uint64_t val = 0;
+	int len = 64;
+	BIT_BITS(buf, 3, 10, val);				// 2 involved bytes
+	BIT_BITS(buf, 7, len, val);				// 9 involved bytes
+	BIT_WBITS(buf, 0, 8, val);				// 1 involved byte
+	BIT_WBITS(buf, 4, 60, val);				// 8 involved bytes
+	BIT_BITS_PADDED(buf, 1, 20, val);
+	BIT_WBITS_PADDED(buf, 1, 20, val);
+	BIT_BITS_BUFFER(buf, 5, 100, dst, 0);	// reads of 9 and 6 bytes, writes of 8 and 5 bytes
+	BIT_WBITS_BUFFER(buf, 200, 10, dst, 0);	// read and write of 2 bytes
+
+	local = BitStats{};
+	bit_stats_local().collect(local);
+
+	const uint64_t* count = local.count;
+	if (count[BIT_STATS_READS + 2] != 2 || count[BIT_STATS_READS + 6] != 1 || count[BIT_STATS_READS + 9] != 2)
+		return false;
+
+	if (count[BIT_STATS_WRITES + 1] != 1 || count[BIT_STATS_WRITES + 2] != 1 || count[BIT_STATS_WRITES + 5] != 1 ||
+		count[BIT_STATS_WRITES + 8] != 2)
+		return false;
+
+	if (count[BIT_STATS_BYTES_READ] != 28 || count[BIT_STATS_BYTES_WRITTEN] != 24 ||
+		count[BIT_STATS_PADDED_READS] != 1 || count[BIT_STATS_PADDED_WRITES] != 1)
+		return false;
+
+	if (count[BIT_STATS_COPIES] != 2 || count[BIT_STATS_COPY_BITS] != 110 ||
+		count[BIT_STATS_COPY_LENS + 6] != 1 || count[BIT_STATS_COPY_LENS + 3] != 1)
+		return false;
+
+	return true;
+}
+
+// run the calls on several threads; the counters of every thread and their
+//     sum after the threads have exited must match
+bool bit_instrument_test()
+{
+	const int thread_count = 4;
+
+	bit_stats_reset();
+
+	std::vector<std::thread> threads;
+	std::vector<BitStats> locals(thread_count);
+	std::vector<char> passed(thread_count, 0);
+	for (int t = 0; t < thread_count; ++t)
+	{
+		threads.emplace_back([&locals, &passed, t]() {
+			passed[t] = bit_instrument_calls(locals[t]);
+		});
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	for (int t = 0; t < thread_count; ++t)
+	{
+		if (!passed[t] || locals[t].threads != 1)
+			return false;
+		for (int i = 0; i < BIT_STATS_COUNT; ++i)
+			if (locals[t].count[i] != locals[0].count[i])
+				return false;
+	}
+
+	BitStats stats = bit_stats_snapshot();
+	for (int i = 0; i < BIT_STATS_COUNT; ++i)
+		if (stats.count[i] != thread_count * locals[0].count[i])
+			return false;
+
+	bit_stats_reset();
+	return true;
+}
@@ -0,0 +1,228 @@
+/* bit_morton.h
+ * definitions for Morton (Z-order) encoding and decoding of 2D and 3D
+ * coordinates, also for keys stored as bitfields of a buffer.
+ */
+
+#ifndef __BIT_MORTON_H__
+#define __BIT_MORTON_H__
+
+#pragma warning(disable : 26451)
+
+#include <cstddef>
+
+#include "bit_bits.h"
+#include "bit_extract.h"
+
+/********************************************************************
+ * utility functions for spreading and compacting bits; the magic-bits
+ *     shifts and masks are used when BMI2 (PDEP/PEXT) is not available
+ */
+
+/* bits of a 2D key holding x (y is shifted left by one) */
+#define MORTON2D_MASK 0x5555555555555555ULL
+
+/* bits of a 3D key holding x (y and z are shifted left by one and two) */
+#define MORTON3D_MASK 0x1249249249249249ULL
+
+/* spread the low 32 bits of 'val' to the even bits */
+static inline uint64_t morton2d_spread(uint64_t val)
+{
+#if BIT_HAVE_BMI2
+    return bit_pdep64(val, MORTON2D_MASK);
+#else
+    val &= 0x00000000FFFFFFFFULL;
+    val = (val | (val << 16)) & 0x0000FFFF0000FFFFULL;
+    val = (val | (val << 8)) & 0x00FF00FF00FF00FFULL;
+    val = (val | (val << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    val = (val | (val << 2)) & 0x3333333333333333ULL;
+    val = (val | (val << 1)) & 0x5555555555555555ULL;
+    return val;
+#endif
+}
+
+/* compact the even bits of 'val' to the low 32 bits */
+static inline uint64_t morton2d_compact(uint64_t val)
+{
+#if BIT_HAVE_BMI2
+    return bit_pext64(val, MORTON2D_MASK);
+#else
+    val &= 0x5555555555555555ULL;
+    val = (val ^ (val >> 1)) & 0x3333333333333333ULL;
+    val = (val ^ (val >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+    val = (val ^ (val >> 4)) & 0x00FF00FF00FF00FFULL;
+    val = (val ^ (val >> 8)) & 0x0000FFFF0000FFFFULL;
+    val = (val ^ (val >> 16)) & 0x00000000FFFFFFFFULL;
+    return val;
+#endif
+}
+
+/* spread the low 21 bits of 'val' to every third bit */
+static inline uint64_t morton3d_spread(uint64_t val)
+{
+#if BIT_HAVE_BMI2
+    return bit_pdep64(val, MORTON3D_MASK);
+#else
+    val &= 0x00000000001FFFFFULL;
+    val = (val | (val << 32)) & 0x001F00000000FFFFULL;
+    val = (val | (val << 16)) & 0x001F0000FF0000FFULL;
+    val = (val | (val << 8)) & 0x100F00F00F00F00FULL;
+    val = (val | (val << 4)) & 0x10C30C30C30C30C3ULL;
+    val = (val | (val << 2)) & 0x1249249249249249ULL;
+    return val;
+#endif
+}
+
+/* compact every third bit of 'val' to the low 21 bits */
+static inline uint64_t morton3d_compact(uint64_t val)
+{
+#if BIT_HAVE_BMI2
+    return bit_pext64(val, MORTON3D_MASK);
+#else
+    val &= 0x1249249249249249ULL;
+    val = (val ^ (val >> 2)) & 0x10C30C30C30C30C3ULL;
+    val = (val ^ (val >> 4)) & 0x100F00F00F00F00FULL;
+    val = (val ^ (val >> 8)) & 0x001F0000FF0000FFULL;
+    val = (val ^ (val >> 16)) & 0x001F00000000FFFFULL;
+    val = (val ^ (val >> 32)) & 0x00000000001FFFFFULL;
+    return val;
+#endif
+}
+
+/********************************************************************
+ * Functions for encoding and decoding Morton keys; x occupies bit 0 of
+ *     the key, y bit 1 (and z bit 2)
+ */
+
+/* encode 2D coordinates of 16 bits to a 32-bit key */
+static inline uint32_t morton2d_encode16(uint16_t x, uint16_t y)
+{
+    return (uint32_t)(morton2d_spread(x) | (morton2d_spread(y) << 1));
+}
+
+/* decode a 32-bit key to 2D coordinates of 16 bits */
+static inline void morton2d_decode16(uint32_t key, uint16_t& x, uint16_t& y)
+{
+    x = (uint16_t)morton2d_compact(key);
+    y = (uint16_t)morton2d_compact(key >> 1);
+}
+
+/* encode 2D coordinates of 32 bits to a 64-bit key */
+static inline uint64_t morton2d_encode32(uint32_t x, uint32_t y)
+{
+    return morton2d_spread(x) | (morton2d_spread(y) << 1);
+}
+
+/* decode a 64-bit key to 2D coordinates of 32 bits */
+static inline void morton2d_decode32(uint64_t key, uint32_t& x, uint32_t& y)
+{
+    x = (uint32_t)morton2d_compact(key);
+    y = (uint32_t)morton2d_compact(key >> 1);
+}
+
+/* encode 3D coordinates of 21 bits to a 63-bit key */
+static inline uint64_t morton3d_encode21(uint32_t x, uint32_t y, uint32_t z)
+{
+    return morton3d_spread(x) | (morton3d_spread(y) << 1) | (morton3d_spread(z) << 2);
+}
+
+/* decode a 63-bit key to 3D coordinates of 21 bits */
+static inline void morton3d_decode21(uint64_t key, uint32_t& x, uint32_t& y, uint32_t& z)
+{
+    x = (uint32_t)morton3d_compact(key);
+    y = (uint32_t)morton3d_compact(key >> 1);
+    z = (uint32_t)morton3d_compact(key >> 2);
+}
+
+/********************************************************************
+ * Functions for encoding and decoding arrays of Morton keys
+ */
+
+/* encode 'n' pairs of 2D coordinates of 32 bits to 64-bit keys */
+static inline void morton2d_encode32_n(const uint32_t* x, const uint32_t* y, uint64_t* keys, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        keys[i] = morton2d_encode32(x[i], y[i]);
+}
+
+/* decode 'n' 64-bit keys to pairs of 2D coordinates of 32 bits */
+static inline void morton2d_decode32_n(const uint64_t* keys, uint32_t* x, uint32_t* y, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        morton2d_decode32(keys[i], x[i], y[i]);
+}
+
+/* encode 'n' triples of 3D coordinates of 21 bits to 63-bit keys */
+static inline void morton3d_encode21_n(const uint32_t* x, const uint32_t* y, const uint32_t* z, uint64_t* keys, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        keys[i] = morton3d_encode21(x[i], y[i], z[i]);
+}
+
+/* decode 'n' 63-bit keys to triples of 3D coordinates of 21 bits */
+static inline void morton3d_decode21_n(const uint64_t* keys, uint32_t* x, uint32_t* y, uint32_t* z, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        morton3d_decode21(keys[i], x[i], y[i], z[i]);
+}
+
+/********************************************************************
+ * Functions for reading and writing Morton keys stored as bitfields; a
+ *     key of coordinates with 'len' bits is a bitfield of 2 * 'len' (2D,
+ *     'len' up to 32) or 3 * 'len' (3D, 'len' up to 21) bits
+ */
+
+/* extract a 2D key and decode it
+ * buf ... buffer
+ * bit ... bit address
+ * len ... length of each coordinate
+ * x, y .. result coordinates
+ */
+template<typename _BufTy, typename _BitTy>
+static inline void bit_morton2d(_BufTy buf, _BitTy bit, int len, uint32_t& x, uint32_t& y)
+{
+    uint64_t key = 0;
+    BIT_BITS(buf, bit, 2 * len, key);
+    morton2d_decode32(key, x, y);
+}
+
+/* encode 2D coordinates and write the key
+ * buf ... buffer
+ * bit ... bit address
+ * len ... length of each coordinate
+ * x, y .. coordinates to write
+ */
+template<typename _BufTy, typename _BitTy>
+static inline void bit_wmorton2d(_BufTy buf, _BitTy bit, int len, uint32_t x, uint32_t y)
+{
+    uint64_t key = morton2d_encode32(x, y);
+    BIT_WBITS(buf, bit, 2 * len, key);
+}
+
+/* extract a 3D key and decode it
+ * buf ..... buffer
+ * bit ..... bit address
+ * len ..... length of each coordinate
+ * x, y, z . result coordinates
+ */
+template<typename _BufTy, typename _BitTy>
+static inline void bit_morton3d(_BufTy buf, _BitTy bit, int len, uint32_t& x, uint32_t& y, uint32_t& z)
+{
+    uint64_t key = 0;
+    BIT_BITS(buf, bit, 3 * len, key);
+    morton3d_decode21(key, x, y, z);
+}
+
+/* encode 3D coordinates and write the key
+ * buf ..... buffer
+ * bit ..... bit address
+ * len ..... length of each coordinate
+ * x, y, z . coordinates to write
+ */
+template<typename _BufTy, typename _BitTy>
+static inline void bit_wmorton3d(_BufTy buf, _BitTy bit, int len, uint32_t x, uint32_t y, uint32_t z)
+{
+    uint64_t key = morton3d_encode21(x, y, z);
+    BIT_WBITS(buf, bit, 3 * len, key);
+}
+
+#endif /* __BIT_MORTON_H__ */
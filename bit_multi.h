@@ -0,0 +1,142 @@
+/* bit_multi.h
+ * definitions for reading several independent bitstreams, e.g. separate
+ * messages or substreams, in lockstep: a chain of bitfields of one stream is
+ * serially dependent, as the address of a field follows from the length of
+ * the previous one, but the chains of several streams overlap.
+ */
+
+#ifndef __BIT_MULTI_H__
+#define __BIT_MULTI_H__
+
+#pragma warning(disable : 26451)
+
+#include <cstddef>
+
+#include "bit_bits.h"
+
+/* number of streams read in lockstep by the batch functions */
+#define BIT_MULTI_STREAMS 8
+
+/********************************************************************
+ * BitMultiReader - reads consecutive bitfields of '_N' streams of padded
+ *     buffers at a time. a stream is held as a buffer and a bit address
+ *     only, so the state of all streams stays in registers for small '_N';
+ *     every bitfield is read by a single unaligned 8-byte load, without a
+ *     branch. the buffers must provide BYTE_PADDING bytes past the byte
+ *     holding the last bit read.
+ */
+template<int _N>
+class BitMultiReader
+{
+public:
+    /* start reading
+     * bufs .. source buffers of the streams
+     * bits .. bit addresses of the streams, or nullptr for 0
+     */
+    BitMultiReader(const void* const* bufs, const uint64_t* bits = nullptr)
+    {
+        for (int i = 0; i < _N; ++i)
+        {
+            buf_[i] = (const uint8_t*)bufs[i];
+            bit_[i] = (bits != nullptr) ? bits[i] : 0;
+        }
+    }
+
+    /* bit address following the read bits of stream 'i' */
+    uint64_t bit(int i) const { return bit_[i]; }
+
+    /* read a bitfield with the same length of every stream
+     * len ... length of bitfield (0 - 57)
+     * out ... result per stream
+     */
+    void get(int len, uint64_t (&out)[_N])
+    {
+        for (int i = 0; i < _N; ++i)
+        {
+            out[i] = field(i, len);
+            bit_[i] += len;
+        }
+    }
+
+    /* read a bitfield with a length per stream, e.g. taken from the values
+     *     of previous bitfields
+     * lens .. length of bitfield per stream (0 - 57)
+     * out ... result per stream
+     */
+    void get(const int (&lens)[_N], uint64_t (&out)[_N])
+    {
+        for (int i = 0; i < _N; ++i)
+        {
+            out[i] = field(i, lens[i]);
+            bit_[i] += lens[i];
+        }
+    }
+
+    /* skip bits of every stream
+     * len ... number of bits
+     */
+    void skip(uint64_t len)
+    {
+        for (int i = 0; i < _N; ++i)
+            bit_[i] += len;
+    }
+
+private:
+    /* the bitfield at the bit address of stream 'i'; the double shift keeps
+     *     a length of 0 defined
+     */
+    uint64_t field(int i, int len) const
+    {
+        const uint64_t word = BYTE_64_LOAD(buf_[i], ADDR(bit_[i])) << OFFSET(bit_[i]);
+        return (word >> 1) >> (63 - len);
+    }
+
+    const uint8_t* buf_[_N];
+    uint64_t bit_[_N];
+};
+
+/********************************************************************
+ * Functions for decoding batches of small messages with the same layout.
+ *     the messages are decoded BIT_MULTI_STREAMS (or '_N') at a time, field
+ *     by field, and the rest one at a time.
+ */
+
+/* decode the 'k' consecutive bitfields of 'count' messages of padded buffers;
+ *     a field has a fixed length, or a length given by the value of the
+ *     preceding field of the message, e.g. a length prefix
+ * msgs .. buffers of the messages, each starting at bit address 0
+ * count . number of messages
+ * lens .. length of every field (0 - 57), or -1 for the length given by the
+ *         preceding field (whose values must be 0 - 57)
+ * k ..... number of fields
+ * out ... result array, the 'k' fields of message 'i' at 'out + i * k'
+ */
+template<int _N = BIT_MULTI_STREAMS>
+static inline void bit_decode_messages(const void* const* msgs, std::size_t count, const int* lens,
+    std::size_t k, uint64_t* out)
+{
+    std::size_t m = 0;
+    for (; m + _N <= count; m += _N)
+    {
+        BitMultiReader<_N> in(msgs + m);
+        uint64_t vals[_N];
+        int prev[_N] = {};
+        for (std::size_t j = 0; j < k; ++j)
+        {
+            if (lens[j] >= 0)
+                in.get(lens[j], vals);
+            else
+                in.get(prev, vals);
+            for (int i = 0; i < _N; ++i)
+            {
+                out[(m + i) * k + j] = vals[i];
+                prev[i] = (int)vals[i];
+            }
+        }
+    }
+
+    for (; m < count; ++m)
+        bit_decode_messages<1>(msgs + m, 1, lens, k, out + m * k);
+}
+
+#endif /* __BIT_MULTI_H__ */
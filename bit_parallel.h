@@ -0,0 +1,278 @@
+/* bit_parallel.h
+ * definitions for packing, unpacking and copying huge arrays of bitfields on
+ * several threads of a persistent thread pool. requires C++17.
+ */
+
+#ifndef __BIT_PARALLEL_H__
+#define __BIT_PARALLEL_H__
+
+#pragma warning(disable : 26451)
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "bit_bits.h"
+
+/* the shortest range in bits which is split among the threads */
+#define BIT_PARALLEL_MIN_BITS (1 << 16)
+
+/********************************************************************
+ * BitThreadPool - persistent worker threads running the tasks of one job
+ *     at a time. the calling thread is worker 0 and takes part in the job.
+ *     task 't' always runs on worker 't % size()', so a job split into
+ *     'size()' contiguous chunks hands every worker the same chunk on every
+ *     run. the workers are not pinned to CPUs or NUMA nodes.
+ */
+class BitThreadPool
+{
+public:
+    /* start the workers
+     * threads . number of workers including the calling thread, 0 for one
+     *           per hardware thread
+     */
+    explicit BitThreadPool(unsigned threads = 0)
+        : task_(nullptr), tasks_(0), generation_(0), busy_(0), stop_(false)
+    {
+        if (threads == 0)
+            threads = std::thread::hardware_concurrency();
+        for (unsigned id = 1; id < threads; ++id)
+            threads_.emplace_back(&BitThreadPool::work, this, id);
+    }
+
+    ~BitThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            stop_ = true;
+        }
+        start_.notify_all();
+        for (std::thread& thread : threads_)
+            thread.join();
+    }
+
+    BitThreadPool(const BitThreadPool&) = delete;
+    BitThreadPool& operator=(const BitThreadPool&) = delete;
+
+    /* number of workers including the calling thread */
+    unsigned size() const { return (unsigned)threads_.size() + 1; }
+
+    /* run 'task(t)' for every 't' of 0 - 'tasks - 1' and wait for all of
+     *     them; jobs of several calling threads run one after the other
+     */
+    void run(std::size_t tasks, const std::function<void(std::size_t)>& task)
+    {
+        std::lock_guard<std::mutex> job(run_lock_);
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            task_ = &task;
+            tasks_ = tasks;
+            busy_ = (unsigned)threads_.size();
+            ++generation_;
+        }
+        start_.notify_all();
+
+        for (std::size_t t = 0; t < tasks; t += size())
+            task(t);
+
+        std::unique_lock<std::mutex> guard(lock_);
+        done_.wait(guard, [this]() { return busy_ == 0; });
+        task_ = nullptr;
+    }
+
+private:
+    void work(unsigned id)
+    {
+        uint64_t seen = 0;
+        for (;;)
+        {
+            const std::function<void(std::size_t)>* task;
+            std::size_t tasks;
+            {
+                std::unique_lock<std::mutex> guard(lock_);
+                start_.wait(guard, [this, seen]() { return stop_ || generation_ != seen; });
+                if (stop_)
+                    return;
+                seen = generation_;
+                task = task_;
+                tasks = tasks_;
+            }
+
+            for (std::size_t t = id; t < tasks; t += size())
+                (*task)(t);
+
+            std::lock_guard<std::mutex> guard(lock_);
+            if (--busy_ == 0)
+                done_.notify_one();
+        }
+    }
+
+    std::vector<std::thread> threads_;
+    std::mutex run_lock_;
+    std::mutex lock_;
+    std::condition_variable start_;
+    std::condition_variable done_;
+    const std::function<void(std::size_t)>* task_;
+    std::size_t tasks_;
+    uint64_t generation_;
+    unsigned busy_;
+    bool stop_;
+};
+
+/* the pool shared by the parallel functions, started on the first call; the
+ *     function is 'inline' rather than 'static inline', so that every
+ *     translation unit shares it
+ */
+inline BitThreadPool& bit_thread_pool()
+{
+    static BitThreadPool pool;
+    return pool;
+}
+
+/********************************************************************
+ * Functions for packing, unpacking and copying bitfields in parallel.
+ *     the range is split into one contiguous chunk per worker. the chunks
+ *     of a destination start at byte boundaries where the layout has them,
+ *     so no byte is written by two threads; otherwise the few values of a
+ *     chunk sharing a byte with the neighbouring chunk are left out by the
+ *     workers and written by the calling thread once all chunks are done,
+ *     so no locks or atomics are needed.
+ */
+
+/* write 'n' values of array 'src' to consecutive bitfields with length 'len'
+ *     (up to 64 bits), as bit_pack
+ * buf ... destination buffer
+ * bit ... bit address of the first bitfield
+ * len ... length of each bitfield
+ * src ... source array
+ * n ..... number of values
+ * pool .. worker threads
+ */
+template<typename _ValTy>
+static inline void bit_pack_parallel(void* buf, uint64_t bit, int len, const _ValTy* src, std::size_t n,
+    BitThreadPool& pool = bit_thread_pool())
+{
+    const std::size_t chunks = pool.size();
+    if ((uint64_t)n * len < BIT_PARALLEL_MIN_BITS || chunks == 1)
+    {
+        bit_pack(buf, bit, len, src, n);
+        return;
+    }
+
+    /* the first value starting at a byte boundary and the distance of such
+     *     values; none if the boundaries of all values are unaligned
+     */
+    std::size_t first = 8;
+    for (std::size_t i = 0; i < 8; ++i)
+    {
+        if (OFFSET(bit + i * len) == 0)
+        {
+            first = i;
+            break;
+        }
+    }
+    std::size_t period = 8;
+    while (period > 1 && ((period >> 1) * len) % 8 == 0)
+        period >>= 1;
+
+    std::vector<std::size_t> bound(chunks + 1);
+    for (std::size_t c = 0; c <= chunks; ++c)
+    {
+        std::size_t i = (std::size_t)((uint64_t)n * c / chunks);
+        if (c != 0 && c != chunks && first < 8 && i >= first)
+            i -= (i - first) % period;
+        bound[c] = (c != 0 && i < bound[c - 1]) ? bound[c - 1] : i;
+    }
+
+    /* the values of a chunk which do not touch a byte shared with a neighbour */
+    std::vector<std::size_t> safe_lo(chunks), safe_hi(chunks);
+    for (std::size_t c = 0; c < chunks; ++c)
+    {
+        const uint64_t b0 = bit + (uint64_t)bound[c] * len;
+        const uint64_t b1 = bit + (uint64_t)bound[c + 1] * len;
+        std::size_t lo = bound[c], hi = bound[c + 1];
+        if (c != 0 && OFFSET(b0) != 0)
+            lo += (std::size_t)((8 - OFFSET(b0) + len - 1) / len);
+        if (c != chunks - 1 && OFFSET(b1) != 0)
+            hi -= (std::size_t)((OFFSET(b1) + len - 1) / len);
+        safe_lo[c] = (lo < bound[c + 1]) ? lo : bound[c + 1];
+        safe_hi[c] = (hi > safe_lo[c]) ? hi : safe_lo[c];
+    }
+
+    /* an empty range would still rewrite the leading bits of its first byte */
+    pool.run(chunks, [&](std::size_t c) {
+        if (safe_hi[c] != safe_lo[c])
+            bit_pack(buf, bit + (uint64_t)safe_lo[c] * len, len, src + safe_lo[c], safe_hi[c] - safe_lo[c]);
+    });
+
+    for (std::size_t c = 0; c < chunks; ++c)
+    {
+        bit_pack(buf, bit + (uint64_t)bound[c] * len, len, src + bound[c], safe_lo[c] - bound[c]);
+        bit_pack(buf, bit + (uint64_t)safe_hi[c] * len, len, src + safe_hi[c], bound[c + 1] - safe_hi[c]);
+    }
+}
+
+/* extract 'n' consecutive bitfields with length 'len' (up to 64 bits) to array
+ *     'dst', as bit_unpack
+ * buf ... source buffer
+ * bit ... bit address of the first bitfield
+ * len ... length of each bitfield
+ * dst ... destination array
+ * n ..... number of values
+ * pool .. worker threads
+ */
+template<typename _ValTy>
+static inline void bit_unpack_parallel(const void* buf, uint64_t bit, int len, _ValTy* dst, std::size_t n,
+    BitThreadPool& pool = bit_thread_pool())
+{
+    const std::size_t chunks = pool.size();
+    if ((uint64_t)n * len < BIT_PARALLEL_MIN_BITS || chunks == 1)
+    {
+        bit_unpack(buf, bit, len, dst, n);
+        return;
+    }
+
+    pool.run(chunks, [&](std::size_t c) {
+        const std::size_t lo = (std::size_t)((uint64_t)n * c / chunks);
+        const std::size_t hi = (std::size_t)((uint64_t)n * (c + 1) / chunks);
+        bit_unpack(buf, bit + (uint64_t)lo * len, len, dst + lo, hi - lo);
+    });
+}
+
+/* copy bits with custom length from a source buffer, as BIT_WBITS_BUFFER
+ *     (without its limit of 2^31 bits); the ranges must not overlap
+ * buf ... destination buffer
+ * bit ... bit address
+ * len ... length of the range in bits
+ * src ... source buffer
+ * src_bit source bit address
+ * pool .. worker threads
+ */
+static inline void bit_copy_parallel(void* buf, uint64_t bit, uint64_t len, const void* src, uint64_t src_bit,
+    BitThreadPool& pool = bit_thread_pool())
+{
+    const std::size_t chunks = (len < BIT_PARALLEL_MIN_BITS) ? 1 : pool.size();
+
+    /* the chunks of the destination start at byte boundaries */
+    auto bound = [&](std::size_t c) -> uint64_t {
+        if (c == 0 || c == chunks)
+            return (c == 0) ? 0 : len;
+        const uint64_t k = len / chunks * c;
+        return (ADDR(bit + k) << 3 > bit) ? ((ADDR(bit + k) << 3) - bit) : 0;
+    };
+    auto copy = [&](std::size_t c) {
+        const uint64_t k0 = bound(c), k1 = bound(c + 1);
+        BitFragment frag = { src, src_bit + k0, k1 - k0 };
+        (void)concat_bits(buf, bit + k0, &frag, 1);
+    };
+
+    if (chunks == 1)
+        copy(0);
+    else
+        pool.run(chunks, copy);
+}
+
+#endif /* __BIT_PARALLEL_H__ */
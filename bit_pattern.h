@@ -0,0 +1,123 @@
+/* bit_pattern.h
+ * definitions for searching a bitstream for a bit pattern, e.g. the sync word
+ * of a frame, which may start at any bit address.
+ */
+
+#ifndef __BIT_PATTERN_H__
+#define __BIT_PATTERN_H__
+
+#pragma warning(disable : 26451)
+
+#include <cstddef>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "bit_bits.h"
+#include "bit_extract.h"
+
+/********************************************************************
+ * utility functions for searching bit patterns.
+ *     the stream is searched a byte at a time: the 64-bit window at the
+ *     byte is compared with the pattern at all 8 bit phases at once, i.e.
+ *     shifted left by 0 - 7 bits, by one 8-lane (AVX-512) or two 4-lane
+ *     (AVX2) compares. the windows are loaded only while they lie within
+ *     the range; the last positions are checked one by one.
+ */
+
+/* find the phases of a 64-bit window at which the pattern starts
+ * win ... 64-bit window of the stream
+ * mask .. the pattern mask, aligned to the MSB
+ * pat ... the pattern, aligned to the MSB
+ * returns a bitmap of the phases, phase 'k' as the bit 'k' from the LSB
+ */
+static inline uint32_t bit_pattern_phases(uint64_t win, uint64_t mask, uint64_t pat)
+{
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+    const __m512i phase = _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+    __m512i w = _mm512_sllv_epi64(_mm512_set1_epi64((long long)win), phase);
+    return (uint32_t)_mm512_cmpeq_epi64_mask(_mm512_and_si512(w, _mm512_set1_epi64((long long)mask)), _mm512_set1_epi64((long long)pat));
+#elif defined(__AVX2__)
+    const __m256i phase_lo = _mm256_setr_epi64x(0, 1, 2, 3);
+    const __m256i phase_hi = _mm256_setr_epi64x(4, 5, 6, 7);
+    const __m256i w = _mm256_set1_epi64x((long long)win);
+    const __m256i m = _mm256_set1_epi64x((long long)mask);
+    const __m256i p = _mm256_set1_epi64x((long long)pat);
+    __m256i lo = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_sllv_epi64(w, phase_lo), m), p);
+    __m256i hi = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_sllv_epi64(w, phase_hi), m), p);
+    return (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(lo)) | ((uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(hi)) << 4);
+#else
+    uint32_t ret = 0;
+    for (int k = 0; k < 8; ++k)
+        ret |= (uint32_t)(((win << k) & mask) == pat) << k;
+    return ret;
+#endif
+}
+
+/********************************************************************
+ * Functions for searching bit patterns
+ */
+
+/* find every occurrence of a bit pattern in a range of bits; occurrences may
+ *     overlap
+ * buf .......... buffer
+ * start_bit .... bit address of the range
+ * len .......... length of the range in bits
+ * pattern ...... the pattern, in the low bits
+ * pattern_bits . length of the pattern (1 - 64); a pattern longer than 57
+ *                bits does not fit the phases of a window and is compared
+ *                at every position
+ * pos .......... result array of the bit addresses of the occurrences, in
+ *                ascending order
+ * max_pos ...... number of elements of 'pos'
+ * returns the number of occurrences; only the first 'max_pos' are written
+ */
+static inline std::size_t find_pattern(const void* buf, uint64_t start_bit, uint64_t len, uint64_t pattern, int pattern_bits,
+    uint64_t* pos, std::size_t max_pos)
+{
+    const uint8_t* src = (const uint8_t*)buf;
+    std::size_t count = 0;
+    assert(pattern_bits >= 1 && pattern_bits <= 64);
+    if (pattern_bits <= 0 || len < (uint64_t)pattern_bits)
+        return 0;
+
+    const uint64_t mask = MASK64(pattern_bits) << (64 - pattern_bits);
+    const uint64_t pat = (pattern << (64 - pattern_bits)) & mask;
+    const uint64_t last = start_bit + len - pattern_bits;   /* last candidate position */
+    const uint64_t end = ADDR(start_bit + len - 1) + 1;     /* end of the range in bytes */
+    uint64_t adr = ADDR(start_bit);
+
+    /* the phases before the range in the first byte are masked off */
+    uint32_t valid = 0xFF & (0xFF << OFFSET(start_bit));
+    for (; pattern_bits <= BIT_PADDED_MAX_LEN && adr + 8 <= end && (adr << 3) <= last; ++adr, valid = 0xFF)
+    {
+        uint32_t hit = bit_pattern_phases(BYTE_64_LOAD(src, adr), mask, pat) & valid;
+        for (; hit != 0; hit &= hit - 1)
+        {
+            const uint64_t bit = (adr << 3) + bit_ctz64(hit);
+            if (bit > last)
+                break;
+            if (count < max_pos)
+                pos[count] = bit;
+            ++count;
+        }
+    }
+
+    /* the positions of the last window (or all of a long pattern), one by one */
+    for (uint64_t bit = (adr << 3 > start_bit) ? (adr << 3) : start_bit; bit <= last; ++bit)
+    {
+        uint64_t val = 0;
+        BIT_BITS(src, bit, pattern_bits, val);
+        if ((val << (64 - pattern_bits)) == pat)
+        {
+            if (count < max_pos)
+                pos[count] = bit;
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+#endif /* __BIT_PATTERN_H__ */
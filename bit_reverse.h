@@ -0,0 +1,287 @@
+/* bit_reverse.h
+ * definitions for converting the bit order and the byte order of large
+ * buffers, e.g. for streams of bit-reversed bytes (LSB first).
+ */
+
+#ifndef __BIT_REVERSE_H__
+#define __BIT_REVERSE_H__
+
+#pragma warning(disable : 26451)
+
+#include <algorithm>
+#include <cstddef>
+
+#if defined(__SSSE3__) || defined(__AVX__) || defined(__GFNI__)
+#include <immintrin.h>
+#endif
+
+#include "bit_bits.h"
+
+/********************************************************************
+ * utility functions for reversing the bit order of bytes
+ */
+
+/* reverse the bit order of a single byte (8 bit) */
+#define BIT_REVERSE8(val) \
+    ((uint8_t)(((((uint32_t)(val) * 0x0802u & 0x22110u) | ((uint32_t)(val) * 0x8020u & 0x88440u)) * 0x10101u) >> 16))
+
+/* reverse the bit order of each byte of a long long (64 bit, 8 byte) */
+static inline uint64_t bit_reverse8_x8(uint64_t val)
+{
+    val = ((val >> 1) & 0x5555555555555555ULL) | ((val & 0x5555555555555555ULL) << 1);
+    val = ((val >> 2) & 0x3333333333333333ULL) | ((val & 0x3333333333333333ULL) << 2);
+    val = ((val >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((val & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return val;
+}
+
+#if !(defined(__GFNI__) && defined(__AVX512F__)) && (defined(__SSSE3__) || defined(__AVX__))
+
+/* reverse the bit order of each byte of a 128-bit vector by two nibble lookups */
+static inline __m128i bit_reverse8_x16(__m128i val)
+{
+    const __m128i rev_lo = _mm_setr_epi8(0x00, 0x80, 0x40, (char)0xC0, 0x20, (char)0xA0, 0x60, (char)0xE0,
+        0x10, (char)0x90, 0x50, (char)0xD0, 0x30, (char)0xB0, 0x70, (char)0xF0);
+    const __m128i rev_hi = _mm_setr_epi8(0x00, 0x08, 0x04, 0x0C, 0x02, 0x0A, 0x06, 0x0E,
+        0x01, 0x09, 0x05, 0x0D, 0x03, 0x0B, 0x07, 0x0F);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+
+    __m128i lo = _mm_shuffle_epi8(rev_lo, _mm_and_si128(val, nibble));
+    __m128i hi = _mm_shuffle_epi8(rev_hi, _mm_and_si128(_mm_srli_epi16(val, 4), nibble));
+    return _mm_or_si128(lo, hi);
+}
+
+#endif
+
+#if !defined(__GFNI__) && defined(__AVX2__)
+
+/* reverse the bit order of each byte of a 256-bit vector by two nibble lookups */
+static inline __m256i bit_reverse8_x32(__m256i val)
+{
+    const __m256i rev_lo = _mm256_setr_epi8(0x00, 0x80, 0x40, (char)0xC0, 0x20, (char)0xA0, 0x60, (char)0xE0,
+        0x10, (char)0x90, 0x50, (char)0xD0, 0x30, (char)0xB0, 0x70, (char)0xF0,
+        0x00, (char)0x80, 0x40, (char)0xC0, 0x20, (char)0xA0, 0x60, (char)0xE0,
+        0x10, (char)0x90, 0x50, (char)0xD0, 0x30, (char)0xB0, 0x70, (char)0xF0);
+    const __m256i rev_hi = _mm256_setr_epi8(0x00, 0x08, 0x04, 0x0C, 0x02, 0x0A, 0x06, 0x0E,
+        0x01, 0x09, 0x05, 0x0D, 0x03, 0x0B, 0x07, 0x0F,
+        0x00, 0x08, 0x04, 0x0C, 0x02, 0x0A, 0x06, 0x0E,
+        0x01, 0x09, 0x05, 0x0D, 0x03, 0x0B, 0x07, 0x0F);
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+
+    __m256i lo = _mm256_shuffle_epi8(rev_lo, _mm256_and_si256(val, nibble));
+    __m256i hi = _mm256_shuffle_epi8(rev_hi, _mm256_and_si256(_mm256_srli_epi16(val, 4), nibble));
+    return _mm256_or_si256(lo, hi);
+}
+
+#endif
+
+/* the GF(2) bit matrix which reverses the bit order of a byte by GF2P8AFFINEQB */
+#define BIT_REVERSE_GF2P8_MATRIX 0x8040201008040201LL
+
+/********************************************************************
+ * Functions for reversing the bit order of buffers
+ */
+
+/* reverse the bit order of each byte of a buffer; GF2P8AFFINEQB on GFNI,
+ *     pshufb nibble lookups on SSSE3/AVX2, 8 bytes at a time otherwise
+ * dst ... destination buffer (may be equal to 'src')
+ * src ... source buffer
+ * len ... number of bytes
+ */
+static inline void bit_reverse_bytes(void* dst, const void* src, std::size_t len)
+{
+    uint8_t* out = (uint8_t*)dst;
+    const uint8_t* in = (const uint8_t*)src;
+    std::size_t i = 0;
+
+#if defined(__GFNI__) && defined(__AVX512F__)
+    const __m512i matrix = _mm512_set1_epi64(BIT_REVERSE_GF2P8_MATRIX);
+    for (; i + 64 <= len; i += 64)
+        _mm512_storeu_si512((void*)(out + i), _mm512_gf2p8affine_epi64_epi8(_mm512_loadu_si512((const void*)(in + i)), matrix, 0));
+#elif defined(__GFNI__) && defined(__AVX2__)
+    const __m256i matrix = _mm256_set1_epi64x(BIT_REVERSE_GF2P8_MATRIX);
+    for (; i + 32 <= len; i += 32)
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_gf2p8affine_epi64_epi8(_mm256_loadu_si256((const __m256i*)(in + i)), matrix, 0));
+#elif defined(__AVX2__)
+    for (; i + 32 <= len; i += 32)
+        _mm256_storeu_si256((__m256i*)(out + i), bit_reverse8_x32(_mm256_loadu_si256((const __m256i*)(in + i))));
+#endif
+
+#if !(defined(__GFNI__) && defined(__AVX512F__)) && (defined(__SSSE3__) || defined(__AVX__))
+    for (; i + 16 <= len; i += 16)
+        _mm_storeu_si128((__m128i*)(out + i), bit_reverse8_x16(_mm_loadu_si128((const __m128i*)(in + i))));
+#endif
+
+    for (; i + 8 <= len; i += 8)
+        byte_store64(out + i, bit_reverse8_x8(byte_load64(in + i)));
+
+    for (; i < len; ++i)
+        out[i] = BIT_REVERSE8(in[i]);
+}
+
+/* extract the 64 bits at a bit address, by a funnel shift of the 8 bytes at
+ *     ADDR(bit) and the following byte; the following byte is loaded only if
+ *     it holds bits of the field
+ * buf ... buffer
+ * bit ... bit address
+ */
+static inline uint64_t bit_reverse_load64(const uint8_t* buf, uint64_t bit)
+{
+    const int off = (int)OFFSET(bit);
+    const uint64_t word = BYTE_64_LOAD(buf, ADDR(bit));
+    return (off == 0) ? word : ((word << off) | (buf[ADDR(bit) + 8] >> (8 - off)));
+}
+
+/* write 64 bits at a bit address, keeping the bits of the first and the last
+ *     byte outside of the field
+ * buf ... buffer
+ * bit ... bit address
+ * val ... value to write
+ */
+static inline void bit_reverse_store64(uint8_t* buf, uint64_t bit, uint64_t val)
+{
+    const int off = (int)OFFSET(bit);
+    uint8_t* first = buf + ADDR(bit);
+    if (off == 0)
+    {
+        BYTE_64_STORE(first, 0, val);
+        return;
+    }
+    first[0] = (uint8_t)((first[0] & ~(0xFF >> off)) | (val >> (56 + off)));
+    BYTE_64_STORE(first, 1, (val << (8 - off)) | (first[8] & (0xFF >> off)));
+}
+
+/* reverse the order of the bits of a range with custom length, i.e. the first
+ *     bit becomes the last one. an unaligned range is reversed in place by
+ *     swapping the 64-bit words at both ends, each with its bit order reversed
+ * buf ... buffer
+ * bit ... bit address of the range
+ * len ... length of the range in bits
+ */
+static inline void bit_reverse_range(void* buf, uint64_t bit, uint64_t len)
+{
+    if (len < 2)
+        return;
+
+    uint8_t* data = (uint8_t*)buf;
+    if (OFFSET(bit) == 0 && OFFSET(len) == 0)
+    {
+        std::reverse(data + ADDR(bit), data + ADDR(bit + len));
+        bit_reverse_bytes(data + ADDR(bit), data + ADDR(bit), (std::size_t)ADDR(len));
+        return;
+    }
+
+    uint64_t lo = bit, hi = bit + len;
+    for (; hi - lo >= 128; lo += 64, hi -= 64)
+    {
+        const uint64_t head = bit_reverse_load64(data, lo);
+        const uint64_t tail = bit_reverse_load64(data, hi - 64);
+        bit_reverse_store64(data, lo, BYTE_SWAP64(bit_reverse8_x8(tail)));
+        bit_reverse_store64(data, hi - 64, BYTE_SWAP64(bit_reverse8_x8(head)));
+    }
+
+    /* the rest, up to 127 bits, as two fields of up to 63 bits and the middle bit */
+    const int rest = (int)((hi - lo) >> 1);
+    if (rest != 0)
+    {
+        uint64_t head = 0, tail = 0;
+        BIT_BITS(data, lo, rest, head);
+        BIT_BITS(data, hi - rest, rest, tail);
+        BIT_WBITS(data, lo, rest, BYTE_SWAP64(bit_reverse8_x8(tail)) >> (64 - rest));
+        BIT_WBITS(data, hi - rest, rest, BYTE_SWAP64(bit_reverse8_x8(head)) >> (64 - rest));
+    }
+}
+
+/********************************************************************
+ * Functions for reversing the byte order of arrays of words
+ */
+
+/* reverse the byte order of each '_Size' byte word of an array by pshufb
+ *     where available
+ * dst ... destination array (may be equal to 'src')
+ * src ... source array
+ * cnt ... number of words
+ */
+template<int _Size>
+static inline void byte_swap_words(void* dst, const void* src, std::size_t cnt)
+{
+    static_assert(_Size == 2 || _Size == 4 || _Size == 8, "byte_swap_words: word size must be 2, 4 or 8");
+
+    uint8_t* out = (uint8_t*)dst;
+    const uint8_t* in = (const uint8_t*)src;
+    const std::size_t len = cnt * _Size;
+    std::size_t i = 0;
+
+#if defined(__SSSE3__) || defined(__AVX__)
+    uint8_t order[16];
+    for (int j = 0; j < 16; ++j)
+        order[j] = (uint8_t)((j / _Size) * _Size + (_Size - 1 - j % _Size));
+    const __m128i shuffle = _mm_loadu_si128((const __m128i*)order);
+
+#if defined(__AVX512BW__)
+    const __m512i shuffle512 = _mm512_broadcast_i32x4(shuffle);
+    for (; i + 64 <= len; i += 64)
+        _mm512_storeu_si512((void*)(out + i), _mm512_shuffle_epi8(_mm512_loadu_si512((const void*)(in + i)), shuffle512));
+#elif defined(__AVX2__)
+    const __m256i shuffle256 = _mm256_broadcastsi128_si256(shuffle);
+    for (; i + 32 <= len; i += 32)
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(in + i)), shuffle256));
+#endif
+
+    for (; i + 16 <= len; i += 16)
+        _mm_storeu_si128((__m128i*)(out + i), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in + i)), shuffle));
+#endif
+
+    for (; i < len; i += _Size)
+    {
+        if (_Size == 2)
+        {
+            uint16_t word;
+            (void)memcpy(&word, in + i, 2);
+            word = (uint16_t)BYTE_SWAP16(word);
+            (void)memcpy(out + i, &word, 2);
+        }
+        else if (_Size == 4)
+        {
+            uint32_t word;
+            (void)memcpy(&word, in + i, 4);
+            word = (uint32_t)BYTE_SWAP32(word);
+            (void)memcpy(out + i, &word, 4);
+        }
+        else
+        {
+            byte_store64(out + i, BYTE_SWAP64(byte_load64(in + i)));
+        }
+    }
+}
+
+/* reverse the byte order of each short (16 bit, 2 byte) of an array
+ * dst ... destination array (may be equal to 'src')
+ * src ... source array
+ * cnt ... number of words
+ */
+static inline void byte_swap16_buffer(void* dst, const void* src, std::size_t cnt)
+{
+    byte_swap_words<2>(dst, src, cnt);
+}
+
+/* reverse the byte order of each long (32 bit, 4 byte) of an array
+ * dst ... destination array (may be equal to 'src')
+ * src ... source array
+ * cnt ... number of words
+ */
+static inline void byte_swap32_buffer(void* dst, const void* src, std::size_t cnt)
+{
+    byte_swap_words<4>(dst, src, cnt);
+}
+
+/* reverse the byte order of each long long (64 bit, 8 byte) of an array
+ * dst ... destination array (may be equal to 'src')
+ * src ... source array
+ * cnt ... number of words
+ */
+static inline void byte_swap64_buffer(void* dst, const void* src, std::size_t cnt)
+{
+    byte_swap_words<8>(dst, src, cnt);
+}
+
+#endif /* __BIT_REVERSE_H__ */
@@ -0,0 +1,186 @@
+/* bit_rice.h
+ * definitions for Rice coding of signed residuals, e.g. of lossless audio and
+ * telemetry: a residual is folded to an unsigned value 'u' (0, -1, 1, -2, ...
+ * to 0, 1, 2, 3, ...), coded as the quotient 'u >> k' in unary (that many
+ * zeros and a one) followed by the 'k' low bits of 'u'.
+ */
+
+#ifndef __BIT_RICE_H__
+#define __BIT_RICE_H__
+
+#pragma warning(disable : 26451)
+
+#include <cstddef>
+
+#include "bit_bits.h"
+#include "bit_extract.h"
+#include "bit_stream.h"
+
+/********************************************************************
+ * utility functions for Rice coding.
+ *     the quotient is decoded by counting the leading zeros of the window
+ *     of the reader; a window of zeros is skipped whole, so the decoding
+ *     has no branch per bit, and the window is refilled only when it holds
+ *     fewer bits than a short code needs.
+ */
+
+/* the adaptive parameter: an exponential average of the folded values over
+ *     about 16 values, from which 'k' is the position of the highest set
+ *     bit of the average (at most 32); encoder and decoder update it alike
+ */
+struct RiceAdaptive
+{
+    uint64_t sum = 0;   /* 16 times the average */
+
+    int k() const
+    {
+        const uint64_t mean = sum >> 4;
+        const int k = (mean != 0) ? (63 - bit_clz64(mean)) : 0;
+        return (k < 32) ? k : 32;
+    }
+
+    void update(uint64_t u)
+    {
+        sum += u - (sum >> 4);
+    }
+};
+
+/* fold a residual to an unsigned value */
+static inline uint64_t rice_fold(int64_t val)
+{
+    return ((uint64_t)val << 1) ^ (uint64_t)(val >> 63);
+}
+
+/* unfold an unsigned value to a residual */
+static inline int64_t rice_unfold(uint64_t u)
+{
+    return (int64_t)((u >> 1) ^ (0 - (u & 1)));
+}
+
+/* write the Rice code of a folded value
+ * out ... output
+ * k ..... parameter (0 - 32)
+ * u ..... folded value
+ */
+static inline void rice_put(BitWriter& out, int k, uint64_t u)
+{
+    uint64_t q = u >> k;
+    for (; q >= 32; q -= 32)
+        out.put(0, 32);
+
+    /* the zeros of the quotient, the one and the low bits in one bitfield */
+    out.put(((uint64_t)1 << k) | (u & (((uint64_t)1 << k) - 1)), (int)q + 1 + k);
+}
+
+/* read the Rice code of a folded value
+ * in .... input
+ * k ..... parameter (0 - 32)
+ * u ..... result
+ * returns false if the range ends within the code
+ */
+static inline bool rice_get(BitReader& in, int k, uint64_t& u)
+{
+    if (in.avail() < 33 + k)
+        in.refill();
+
+    uint64_t q = 0;
+    while (in.window() == 0)
+    {
+        if (in.left() == 0)
+            return false;
+        q += in.avail();
+        in.skip(in.avail());
+        in.refill();
+    }
+
+    const int z = bit_clz64(in.window());
+    q += z;
+    in.skip(z + 1);
+
+    if (in.avail() < k)
+    {
+        in.refill();
+        if (in.avail() < k)
+            return false;
+    }
+    u = (q << k) | in.get(k);
+    return true;
+}
+
+/********************************************************************
+ * Functions for Rice coding of arrays of residuals
+ */
+
+/* write the Rice codes of 'n' residuals with a fixed parameter
+ * out ... output
+ * k ..... parameter (0 - 32)
+ * src ... residuals
+ * n ..... number of residuals
+ */
+template<typename _ValTy>
+static inline void rice_encode_n(BitWriter& out, int k, const _ValTy* src, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        rice_put(out, k, rice_fold((int64_t)src[i]));
+}
+
+/* read the Rice codes of 'n' residuals with a fixed parameter
+ * in .... input
+ * k ..... parameter (0 - 32)
+ * dst ... result array
+ * n ..... number of residuals
+ * returns the number of decoded residuals, fewer than 'n' if the range
+ *     ends; the reader is then left within the incomplete code
+ */
+template<typename _ValTy>
+static inline std::size_t rice_decode_n(BitReader& in, int k, _ValTy* dst, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        uint64_t u;
+        if (!rice_get(in, k, u))
+            return i;
+        dst[i] = (_ValTy)rice_unfold(u);
+    }
+    return n;
+}
+
+/* write the Rice codes of 'n' residuals with an adaptive parameter
+ * out ... output
+ * state . adaptive parameter, carried from call to call
+ * src ... residuals
+ * n ..... number of residuals
+ */
+template<typename _ValTy>
+static inline void rice_encode_adaptive_n(BitWriter& out, RiceAdaptive& state, const _ValTy* src, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const uint64_t u = rice_fold((int64_t)src[i]);
+        rice_put(out, state.k(), u);
+        state.update(u);
+    }
+}
+
+/* read the Rice codes of 'n' residuals with an adaptive parameter
+ * in .... input
+ * state . adaptive parameter, carried from call to call
+ * dst ... result array
+ * n ..... number of residuals
+ * returns the number of decoded residuals, fewer than 'n' if the range ends
+ */
+template<typename _ValTy>
+static inline std::size_t rice_decode_adaptive_n(BitReader& in, RiceAdaptive& state, _ValTy* dst, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        uint64_t u;
+        if (!rice_get(in, state.k(), u))
+            return i;
+        dst[i] = (_ValTy)rice_unfold(u);
+        state.update(u);
+    }
+    return n;
+}
+
+#endif /* __BIT_RICE_H__ */
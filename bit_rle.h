@@ -0,0 +1,135 @@
+/* bit_rle.h
+ * definitions for run-length coding of ranges of bits, e.g. sparse masks and
+ * fax-like bitmaps: a range is coded as the lengths of its runs of equal
+ * bits, alternately zeros and ones, starting with zeros.
+ */
+
+#ifndef __BIT_RLE_H__
+#define __BIT_RLE_H__
+
+#pragma warning(disable : 26451)
+
+#include <cstddef>
+
+#include "bit_bits.h"
+#include "bit_extract.h"
+
+/********************************************************************
+ * Functions for run-length coding of ranges of bits.
+ *     the first run is a run of zeros, which is empty if the range starts
+ *     with a one; every other run is not empty.
+ */
+
+/* encode a range of bits as run lengths; the range is read as 64-bit
+ *     windows (never past the byte holding its last bit), a run ending in
+ *     a window is found by counting the leading zeros of the window, or of
+ *     its complement for a run of ones, and a window without the end of
+ *     the run is skipped whole
+ * buf ...... buffer
+ * bit ...... bit address of the range
+ * len ...... length of the range in bits
+ * runs ..... result array of the run lengths
+ * max_runs . number of elements of 'runs'
+ * returns the number of runs; only the first 'max_runs' are written
+ */
+static inline std::size_t bit_rle_encode(const void* buf, uint64_t bit, uint64_t len, uint64_t* runs, std::size_t max_runs)
+{
+    const uint8_t* src = (const uint8_t*)buf;
+    const uint64_t end = bit + len;
+    std::size_t count = 0;
+    uint64_t ones = 0;      /* all ones while in a run of ones */
+    uint64_t run = 0;
+
+    while (bit < end)
+    {
+        const int n = (end - bit < 64) ? (int)(end - bit) : 64;
+        uint64_t win = 0;
+        BIT_BITS(src, bit, n, win);
+
+        /* the bits of the window which end the run, aligned to the MSB */
+        win = ((win ^ ones) << (64 - n)) & (~(uint64_t)0 << (64 - n));
+        if (win == 0)
+        {
+            run += n;
+            bit += n;
+            continue;
+        }
+
+        const int z = bit_clz64(win);
+        run += z;
+        bit += z;
+        if (count < max_runs)
+            runs[count] = run;
+        ++count;
+        run = 0;
+        ones = ~ones;
+    }
+
+    if (run > 0)
+    {
+        if (count < max_runs)
+            runs[count] = run;
+        ++count;
+    }
+
+    return count;
+}
+
+/* decode run lengths to a range of bits; the runs are streamed through a
+ *     single 64-bit accumulator, a run covering whole words of the output
+ *     is written 8 bytes at a time, and only the first and the last byte of
+ *     the output are merged
+ * buf ... destination buffer
+ * bit ... bit address of the range
+ * runs .. run lengths
+ * n ..... number of runs
+ * returns the bit address following the range
+ */
+template<typename _BufTy, typename _BitTy>
+static inline uint64_t bit_rle_decode(_BufTy buf, _BitTy bit, const uint64_t* runs, std::size_t n)
+{
+    uint8_t* out = (uint8_t*)(buf) + ADDR(bit);
+    uint64_t total = 0;
+
+    /* start with the untouched leading bits of the first byte */
+    int acc_len = (int)OFFSET(bit);
+    uint64_t acc = (acc_len != 0) ? ((uint64_t)BYTE_8(out, 0) >> (8 - acc_len)) : 0;
+
+    for (std::size_t r = 0; r < n; ++r)
+    {
+        const uint64_t ones = (r & 1) ? ~(uint64_t)0 : 0;
+        uint64_t rem_len = runs[r];
+        total += rem_len;
+
+        while (rem_len > 0)
+        {
+            if (acc_len == 0 && rem_len >= 64)
+            {
+                BYTE_64_STORE(out, 0, ones);
+                out += 8;
+                rem_len -= 64;
+                continue;
+            }
+
+            const int width = (rem_len < (uint64_t)(64 - acc_len)) ? (int)rem_len : (64 - acc_len);
+            acc = (acc << width) | (ones & MASK64(width));
+            acc_len += width;
+            rem_len -= width;
+
+            if (acc_len == 64)
+            {
+                BYTE_64_STORE(out, 0, acc);
+                out += 8;
+                acc = 0;
+                acc_len = 0;
+            }
+        }
+    }
+
+    if (acc_len > 0)
+        BIT_WBITS(out, 0, acc_len, acc);
+
+    return (uint64_t)bit + total;
+}
+
+#endif /* __BIT_RLE_H__ */
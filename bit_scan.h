@@ -0,0 +1,278 @@
+/* bit_scan.h
+ * definitions for filtering arrays of fixed-size records by predicates on
+ * their bitfields, evaluated on several records at a time by SIMD gathers.
+ */
+
+#ifndef __BIT_SCAN_H__
+#define __BIT_SCAN_H__
+
+#pragma warning(disable : 26451)
+
+#include <cstddef>
+#include <vector>
+
+#include "bit_bits.h"
+#include "bit_extract.h"
+#include "bit_gather.h"
+
+/********************************************************************
+ * predicates on bitfields of a record.
+ *     a bitfield is compared as an unsigned value. every comparison is
+ *     compiled to a range test '(field - lo) <= span', optionally negated,
+ *     so the kernels need a single unsigned compare per predicate.
+ */
+
+/* comparison of a bitfield with a constant */
+enum BitScanOp
+{
+    BIT_SCAN_EQ,    /* field == val */
+    BIT_SCAN_NE,    /* field != val */
+    BIT_SCAN_LT,    /* field < val */
+    BIT_SCAN_LE,    /* field <= val */
+    BIT_SCAN_GT,    /* field > val */
+    BIT_SCAN_GE,    /* field >= val */
+    BIT_SCAN_IN     /* val <= field <= hi */
+};
+
+/* combination of the predicates of a scan */
+enum BitScanCombine
+{
+    BIT_SCAN_ALL,   /* AND, a record without predicates is selected */
+    BIT_SCAN_ANY    /* OR, a record without predicates is not selected */
+};
+
+/* a predicate on a bitfield of a record
+ * bit ... bit address of the bitfield in the record
+ * len ... length of the bitfield (1 - 64)
+ * op .... comparison
+ * val ... constant to compare with, lower bound for BIT_SCAN_IN
+ * hi .... upper bound for BIT_SCAN_IN, ignored otherwise
+ */
+struct BitPredicate
+{
+    uint32_t bit;
+    int len;
+    BitScanOp op;
+    uint64_t val;
+    uint64_t hi;
+};
+
+/********************************************************************
+ * BitScanPlan - precompiled list of predicates to evaluate on arrays of
+ *     records. the records are 'stride' bytes apart in a padded buffer,
+ *     i.e. BYTE_PADDING readable bytes must follow the last byte of the
+ *     last record; 7 * 'stride' plus the byte address of a bitfield must
+ *     be below 2^31. the selection bitmap holds record 'i' as the bit
+ *     (i & 63), counted from the LSB, of the word (i >> 6).
+ */
+class BitScanPlan
+{
+public:
+    BitScanPlan() : any_(false) {}
+
+    /* compile 'k' predicates
+     * preds . predicates
+     * k ..... number of predicates
+     * comb .. combination of the predicates
+     */
+    BitScanPlan(const BitPredicate* preds, std::size_t k, BitScanCombine comb = BIT_SCAN_ALL)
+        : terms_(k), any_(comb == BIT_SCAN_ANY)
+    {
+        for (std::size_t i = 0; i < k; ++i)
+        {
+            const BitPredicate& p = preds[i];
+            term& t = terms_[i];
+            t.adr = (int32_t)ADDR(p.bit);
+            t.off = OFFSET(p.bit);
+            t.rsh = 64 - p.len;
+            t.neg = false;
+
+            switch (p.op)
+            {
+            case BIT_SCAN_EQ: t.lo = p.val; t.span = 0; break;
+            case BIT_SCAN_NE: t.lo = p.val; t.span = 0; t.neg = true; break;
+            case BIT_SCAN_LT: t.lo = 0; t.span = p.val - 1; t.neg = (p.val == 0); break;
+            case BIT_SCAN_LE: t.lo = 0; t.span = p.val; break;
+            case BIT_SCAN_GT: t.lo = p.val + 1; t.span = ~(p.val + 1); t.neg = (p.val == ~(uint64_t)0); break;
+            case BIT_SCAN_GE: t.lo = p.val; t.span = ~p.val; break;
+            case BIT_SCAN_IN: t.lo = p.val; t.span = p.hi - p.val; t.neg = (p.hi < p.val); break;
+            }
+
+            /* a predicate which is never true: the negation of the full range */
+            if (t.neg && p.op != BIT_SCAN_NE)
+            {
+                t.lo = 0;
+                t.span = ~(uint64_t)0;
+            }
+        }
+    }
+
+    std::size_t size() const { return terms_.size(); }
+
+    /* evaluate the predicates on 'count' records and write a selection bitmap
+     * buf ..... padded buffer of records
+     * stride .. distance of consecutive records in bytes
+     * count ... number of records
+     * bitmap .. result bitmap with (count + 63) / 64 words; the bits past
+     *           'count' are zero
+     * returns the number of selected records
+     */
+    std::size_t scan(const void* buf, std::size_t stride, std::size_t count, uint64_t* bitmap) const
+    {
+        const uint8_t* src = (const uint8_t*)buf;
+        std::size_t selected = 0;
+
+        for (std::size_t base = 0; base < count; base += 64)
+        {
+            uint64_t word = match_block(src + base * stride, stride, (count - base < 64) ? (count - base) : 64);
+            bitmap[base >> 6] = word;
+            selected += bit_popcount64(word);
+        }
+
+        return selected;
+    }
+
+    /* evaluate the predicates on 'count' records and write the indices of the
+     *     selected ones
+     * buf ..... padded buffer of records
+     * stride .. distance of consecutive records in bytes
+     * count ... number of records
+     * index ... result array with up to 'count' elements, in ascending order
+     * returns the number of selected records
+     */
+    std::size_t select(const void* buf, std::size_t stride, std::size_t count, uint32_t* index) const
+    {
+        const uint8_t* src = (const uint8_t*)buf;
+        std::size_t selected = 0;
+
+        for (std::size_t base = 0; base < count; base += 64)
+        {
+            uint64_t word = match_block(src + base * stride, stride, (count - base < 64) ? (count - base) : 64);
+            for (; word != 0; word &= word - 1)
+                index[selected++] = (uint32_t)(base + bit_ctz64(word));
+        }
+
+        return selected;
+    }
+
+private:
+    struct term
+    {
+        int32_t adr;
+        uint64_t off;
+        uint64_t rsh;
+        uint64_t lo;
+        uint64_t span;
+        bool neg;
+    };
+
+    /* evaluate the predicates on a record */
+    bool match_one(const uint8_t* rec) const
+    {
+        for (const term& t : terms_)
+        {
+            uint64_t field = BIT_GATHER_ONE(rec, t.adr, t.off, t.rsh);
+            bool m = ((field - t.lo) <= t.span) != t.neg;
+            if (m == any_)
+                return any_;
+        }
+
+        return !any_;
+    }
+
+    /* evaluate the predicates on up to 64 records, 8 (AVX-512) or 4 (AVX2)
+     *     at a time; a group stops as soon as its result is decided
+     */
+    uint64_t match_block(const uint8_t* rec, std::size_t stride, std::size_t cnt) const
+    {
+        uint64_t word = 0;
+        std::size_t i = 0;
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+        const __m256i lane = _mm256_setr_epi32(0, (int)stride, (int)(2 * stride), (int)(3 * stride),
+            (int)(4 * stride), (int)(5 * stride), (int)(6 * stride), (int)(7 * stride));
+        const uint32_t done = any_ ? 0xFF : 0x00;
+
+        for (; i + 8 <= cnt; i += 8)
+        {
+            uint32_t acc = any_ ? 0x00 : 0xFF;
+            for (const term& t : terms_)
+            {
+                __m512i field = bit_gather_x8(rec + i * stride, _mm256_add_epi32(lane, _mm256_set1_epi32(t.adr)),
+                    _mm512_set1_epi64((long long)t.off), _mm512_set1_epi64((long long)t.rsh));
+                uint32_t m = (uint32_t)_mm512_cmple_epu64_mask(_mm512_sub_epi64(field, _mm512_set1_epi64((long long)t.lo)),
+                    _mm512_set1_epi64((long long)t.span)) ^ (t.neg ? 0xFF : 0x00);
+                acc = any_ ? (acc | m) : (acc & m);
+                if (acc == done)
+                    break;
+            }
+            word |= (uint64_t)acc << i;
+        }
+#elif defined(__AVX2__)
+        const __m128i lane = _mm_setr_epi32(0, (int)stride, (int)(2 * stride), (int)(3 * stride));
+        const __m256i sign = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+        const uint32_t done = any_ ? 0x0F : 0x00;
+
+        for (; i + 4 <= cnt; i += 4)
+        {
+            uint32_t acc = any_ ? 0x00 : 0x0F;
+            for (const term& t : terms_)
+            {
+                __m256i field = bit_gather_x4(rec + i * stride, _mm_add_epi32(lane, _mm_set1_epi32(t.adr)),
+                    _mm256_set1_epi64x((long long)t.off), _mm256_set1_epi64x((long long)t.rsh));
+                /* unsigned 'greater than' as signed compare of the values with flipped sign bits */
+                __m256i gt = _mm256_cmpgt_epi64(_mm256_xor_si256(_mm256_sub_epi64(field, _mm256_set1_epi64x((long long)t.lo)), sign),
+                    _mm256_set1_epi64x((long long)(t.span ^ 0x8000000000000000ULL)));
+                uint32_t m = (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(gt)) ^ (t.neg ? 0x00 : 0x0F);
+                acc = any_ ? (acc | m) : (acc & m);
+                if (acc == done)
+                    break;
+            }
+            word |= (uint64_t)acc << i;
+        }
+#endif
+
+        for (; i < cnt; ++i)
+        {
+            if (match_one(rec + i * stride))
+                word |= (uint64_t)1 << i;
+        }
+
+        return word;
+    }
+
+    std::vector<term> terms_;
+    bool any_;
+};
+
+/********************************************************************
+ * Functions for filtering records by a precompiled plan
+ */
+
+/* write the selection bitmap of 'count' records
+ * buf ..... padded buffer of records
+ * stride .. distance of consecutive records in bytes
+ * count ... number of records
+ * plan .... predicates
+ * bitmap .. result bitmap with (count + 63) / 64 words
+ * returns the number of selected records
+ */
+static inline std::size_t scan_records(const void* buf, std::size_t stride, std::size_t count, const BitScanPlan& plan, uint64_t* bitmap)
+{
+    return plan.scan(buf, stride, count, bitmap);
+}
+
+/* write the indices of the selected records among 'count' records
+ * buf ..... padded buffer of records
+ * stride .. distance of consecutive records in bytes
+ * count ... number of records
+ * plan .... predicates
+ * index ... result array with up to 'count' elements
+ * returns the number of selected records
+ */
+static inline std::size_t select_records(const void* buf, std::size_t stride, std::size_t count, const BitScanPlan& plan, uint32_t* index)
+{
+    return plan.select(buf, stride, count, index);
+}
+
+#endif /* __BIT_SCAN_H__ */
@@ -0,0 +1,178 @@
+/* bit_schema.h
+ * definitions for decoding messages whose layout is only known at run time,
+ * e.g. loaded from configuration: a table of consecutive fields is compiled
+ * once into a flat program of pre-resolved operations, which is then run over
+ * one or many messages.
+ */
+
+#ifndef __BIT_SCHEMA_H__
+#define __BIT_SCHEMA_H__
+
+#pragma warning(disable : 26451)
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+#include "bit_bits.h"
+#include "bit_gather.h"
+
+/********************************************************************
+ * field tables. the fields of a message are consecutive, the first one at
+ *     bit address 0; a field without an output slot only advances the bit
+ *     address, e.g. spare or reserved bits.
+ */
+
+/* representation of a field */
+enum BitFieldType
+{
+    BIT_FIELD_UNSIGNED,     /* unsigned integer */
+    BIT_FIELD_SIGNED,       /* two's complement integer */
+    BIT_FIELD_SIGN_MAG      /* sign bit (1 = negative) followed by the magnitude */
+};
+
+/* a field of a message
+ * len .... length of the field (1 - 64; 2 - 64 for BIT_FIELD_SIGN_MAG)
+ * type ... representation
+ * scale .. factor applied to the value
+ * slot ... index of the output value, or -1 to skip the field
+ */
+struct BitSchemaField
+{
+    int len;
+    BitFieldType type;
+    double scale;
+    int slot;
+};
+
+/********************************************************************
+ * BitSchema - compiled decode program of a field table. every operation
+ *     holds the byte address, the bit offset and the shift count of its
+ *     field, the mask of the magnitude, the scale and the output slot, so
+ *     running the program only loads, shifts, converts and stores; skipped
+ *     fields produce no operation. the messages are read from padded
+ *     buffers, i.e. BYTE_PADDING readable bytes must follow the last byte
+ *     of a message, and must be below 2^31 bytes.
+ */
+class BitSchema
+{
+public:
+    BitSchema() : bits_(0), slots_(0) {}
+
+    /* compile a table of 'n' fields; the lengths of the fields with an
+     *     output slot are checked in debug builds
+     * fields . field table
+     * n ...... number of fields
+     */
+    BitSchema(const BitSchemaField* fields, std::size_t n)
+        : bits_(0), slots_(0)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const BitSchemaField& f = fields[i];
+            if (f.slot >= 0)
+            {
+                assert(f.len >= ((f.type == BIT_FIELD_SIGN_MAG) ? 2 : 1) && f.len <= 64);
+
+                op o;
+                o.adr = (int32_t)ADDR(bits_);
+                o.off = (uint8_t)OFFSET(bits_);
+                o.rsh = (uint8_t)(64 - f.len);
+                o.type = (uint8_t)f.type;
+                o.slot = f.slot;
+                o.mask = (f.type == BIT_FIELD_SIGN_MAG) ? MASK64(f.len - 1) : MASK64(f.len);
+                o.scale = f.scale;
+                ops_.push_back(o);
+
+                if (f.slot + 1 > slots_)
+                    slots_ = f.slot + 1;
+            }
+            bits_ += (uint64_t)f.len;
+        }
+    }
+
+    /* number of operations, i.e. of fields with an output slot */
+    std::size_t size() const { return ops_.size(); }
+
+    /* number of output values of a message, the highest slot plus one */
+    std::size_t slots() const { return (std::size_t)slots_; }
+
+    /* length of a message in bits */
+    uint64_t bits() const { return bits_; }
+
+    /* decode a message to scaled values
+     * buf ... padded buffer
+     * out ... result array with 'slots()' elements; slots without a field
+     *         are not written
+     */
+    void run(const void* buf, double* out) const
+    {
+        const uint8_t* src = (const uint8_t*)buf;
+        for (const op& o : ops_)
+            out[o.slot] = (double)value(src, o) * o.scale;
+    }
+
+    /* decode a message to unscaled, sign-extended values
+     * buf ... padded buffer
+     * out ... result array with 'slots()' elements; slots without a field
+     *         are not written
+     */
+    void run(const void* buf, int64_t* out) const
+    {
+        const uint8_t* src = (const uint8_t*)buf;
+        for (const op& o : ops_)
+            out[o.slot] = value(src, o);
+    }
+
+    /* decode 'count' messages
+     * buf ... first padded message
+     * stride  distance of consecutive messages in bytes
+     * count . number of messages
+     * out ... result array with 'slots() * count' elements, message by message
+     */
+    template<typename _ValTy>
+    void run_batch(const void* buf, std::size_t stride, std::size_t count, _ValTy* out) const
+    {
+        for (std::size_t msg = 0; msg < count; ++msg)
+            run((const uint8_t*)buf + msg * stride, out + msg * (std::size_t)slots_);
+    }
+
+private:
+    struct op
+    {
+        int32_t adr;
+        uint8_t off;
+        uint8_t rsh;
+        uint8_t type;
+        int32_t slot;
+        uint64_t mask;
+        double scale;
+    };
+
+    /* value of the field of an operation; the 64-bit window starting at the
+     *     field is shifted right arithmetically for a signed field, so the
+     *     sign extension costs nothing
+     */
+    static int64_t value(const uint8_t* src, const op& o)
+    {
+        const uint64_t win = BIT_GATHER_ONE(src, o.adr, o.off, 0);
+        switch (o.type)
+        {
+        case BIT_FIELD_SIGNED:
+            return (int64_t)win >> o.rsh;
+        case BIT_FIELD_SIGN_MAG:
+        {
+            const int64_t mag = (int64_t)((win >> o.rsh) & o.mask);
+            return ((int64_t)win < 0) ? -mag : mag;
+        }
+        default:
+            return (int64_t)(win >> o.rsh);
+        }
+    }
+
+    std::vector<op> ops_;
+    uint64_t bits_;
+    int slots_;
+};
+
+#endif /* __BIT_SCHEMA_H__ */
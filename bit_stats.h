@@ -0,0 +1,292 @@
+/* bit_stats.h
+ * definitions for the opt-in instrumentation of the bitfield functions:
+ * per-thread counters of the calls by number of involved bytes, of the bytes
+ * read, re-read and written, and of the lengths of the *_BUFFER copies,
+ * dumped as JSON. the hooks of bit_bits.h update the counters only when
+ * BIT_INSTRUMENT is defined before it is included, otherwise they expand to
+ * nothing. requires C++17.
+ */
+
+#ifndef __BIT_STATS_H__
+#define __BIT_STATS_H__
+
+#pragma warning(disable : 26451)
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "byte_bytes.h"
+
+/********************************************************************
+ * counters. a counter is an index of BitStats::count; the calls are
+ *     counted by the number of involved bytes (1 - 9, the arm taken by
+ *     BIT_BITS/BIT_WBITS, 9 is the straddle path of BIT_W72), the copy
+ *     lengths by the bucket floor(log2(len)).
+ */
+#define BIT_STATS_READS         0   /* BIT_BITS calls, 10 counters by involved bytes */
+#define BIT_STATS_WRITES        10  /* BIT_WBITS calls, 10 counters by involved bytes */
+#define BIT_STATS_PADDED_READS  20  /* BIT_BITS_PADDED calls */
+#define BIT_STATS_PADDED_WRITES 21  /* BIT_WBITS_PADDED calls */
+#define BIT_STATS_BYTES_READ    22  /* bytes read by BIT_BITS */
+#define BIT_STATS_BYTES_REREAD  23  /* bytes read by BIT_BITS which the previous call of the thread read too */
+#define BIT_STATS_BYTES_WRITTEN 24  /* bytes modified by BIT_WBITS */
+#define BIT_STATS_COPIES        25  /* BIT_BITS_BUFFER and BIT_WBITS_BUFFER calls */
+#define BIT_STATS_COPY_BITS     26  /* bits copied by BIT_BITS_BUFFER and BIT_WBITS_BUFFER */
+#define BIT_STATS_COPY_LENS     27  /* copies, 32 counters by floor(log2(len)) */
+#define BIT_STATS_COUNT         59
+
+/* snapshot of the counters of one or more threads */
+struct BitStats
+{
+    uint64_t count[BIT_STATS_COUNT];
+    uint64_t threads;
+};
+
+/* counters of a thread; only the owning thread modifies them, other threads
+ *     may read them at any time
+ */
+class BitStatsCounters
+{
+public:
+    BitStatsCounters();
+    ~BitStatsCounters();
+
+    /* add 'n' to counter 'idx'; a relaxed load and store, not a locked
+     *     read-modify-write, as no other thread writes the counter
+     */
+    void add(int idx, uint64_t n)
+    {
+        count_[idx].store(count_[idx].load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    /* add the counters to a snapshot */
+    void collect(BitStats& stats) const
+    {
+        for (int i = 0; i < BIT_STATS_COUNT; ++i)
+            stats.count[i] += count_[i].load(std::memory_order_relaxed);
+        stats.threads += 1;
+    }
+
+    void reset()
+    {
+        for (int i = 0; i < BIT_STATS_COUNT; ++i)
+            count_[i].store(0, std::memory_order_relaxed);
+    }
+
+    /* byte range of the last BIT_BITS call of the thread */
+    std::uintptr_t last_lo = 0;
+    std::uintptr_t last_hi = 0;
+
+private:
+    std::atomic<uint64_t> count_[BIT_STATS_COUNT];
+};
+
+/* counters of all threads: the live ones and the sum of the exited ones.
+ *     the functions are 'inline' rather than 'static inline', so that every
+ *     translation unit shares a single registry
+ */
+struct BitStatsRegistry
+{
+    std::mutex lock;
+    std::vector<BitStatsCounters*> live;
+    BitStats exited{};
+};
+
+inline BitStatsRegistry& bit_stats_registry()
+{
+    static BitStatsRegistry registry;
+    return registry;
+}
+
+inline BitStatsCounters::BitStatsCounters()
+{
+    reset();
+    BitStatsRegistry& reg = bit_stats_registry();
+    std::lock_guard<std::mutex> guard(reg.lock);
+    reg.live.push_back(this);
+}
+
+inline BitStatsCounters::~BitStatsCounters()
+{
+    BitStatsRegistry& reg = bit_stats_registry();
+    std::lock_guard<std::mutex> guard(reg.lock);
+    collect(reg.exited);
+    for (std::size_t i = 0; i < reg.live.size(); ++i)
+    {
+        if (reg.live[i] == this)
+        {
+            reg.live.erase(reg.live.begin() + i);
+            break;
+        }
+    }
+}
+
+/* counters of the calling thread */
+inline BitStatsCounters& bit_stats_local()
+{
+    thread_local BitStatsCounters counters;
+    return counters;
+}
+
+/********************************************************************
+ * hooks called by the bitfield functions of bit_bits.h
+ */
+
+/* a BIT_BITS call reading 'bytes' bytes at 'ptr' */
+inline void bit_stats_read(const void* ptr, int bytes)
+{
+    BitStatsCounters& s = bit_stats_local();
+    const std::uintptr_t lo = (std::uintptr_t)ptr;
+    const std::uintptr_t hi = lo + (std::uintptr_t)bytes;
+
+    s.add(BIT_STATS_READS + bytes, 1);
+    s.add(BIT_STATS_BYTES_READ, bytes);
+    if (lo < s.last_hi && hi > s.last_lo)
+        s.add(BIT_STATS_BYTES_REREAD, ((hi < s.last_hi) ? hi : s.last_hi) - ((lo > s.last_lo) ? lo : s.last_lo));
+
+    s.last_lo = lo;
+    s.last_hi = hi;
+}
+
+/* a BIT_WBITS call modifying 'bytes' bytes */
+inline void bit_stats_write(int bytes)
+{
+    BitStatsCounters& s = bit_stats_local();
+    s.add(BIT_STATS_WRITES + bytes, 1);
+    s.add(BIT_STATS_BYTES_WRITTEN, bytes);
+}
+
+/* a BIT_BITS_PADDED call */
+inline void bit_stats_padded_read()
+{
+    bit_stats_local().add(BIT_STATS_PADDED_READS, 1);
+}
+
+/* a BIT_WBITS_PADDED call */
+inline void bit_stats_padded_write()
+{
+    bit_stats_local().add(BIT_STATS_PADDED_WRITES, 1);
+}
+
+/* a BIT_BITS_BUFFER or BIT_WBITS_BUFFER call copying 'len' bits */
+inline void bit_stats_copy(uint64_t len)
+{
+    BitStatsCounters& s = bit_stats_local();
+    int bucket = 0;
+    while (bucket < 31 && (len >> (bucket + 1)) != 0)
+        ++bucket;
+
+    s.add(BIT_STATS_COPIES, 1);
+    s.add(BIT_STATS_COPY_BITS, len);
+    s.add(BIT_STATS_COPY_LENS + bucket, 1);
+}
+
+/********************************************************************
+ * Functions for reading, resetting and dumping the counters
+ */
+
+/* sum of the counters of all threads, including the exited ones */
+inline BitStats bit_stats_snapshot()
+{
+    BitStatsRegistry& reg = bit_stats_registry();
+    std::lock_guard<std::mutex> guard(reg.lock);
+
+    BitStats stats = reg.exited;
+    for (const BitStatsCounters* counters : reg.live)
+        counters->collect(stats);
+    return stats;
+}
+
+/* reset the counters of all threads and the last range read by the calling
+ *     thread; the threads should be idle, an update running concurrently may
+ *     be lost or survive the reset
+ */
+inline void bit_stats_reset()
+{
+    BitStatsCounters& self = bit_stats_local();
+    self.last_lo = 0;
+    self.last_hi = 0;
+
+    BitStatsRegistry& reg = bit_stats_registry();
+    std::lock_guard<std::mutex> guard(reg.lock);
+
+    reg.exited = BitStats{};
+    for (BitStatsCounters* counters : reg.live)
+        counters->reset();
+}
+
+/* format a snapshot as a JSON object; the call histograms are keyed by the
+ *     number of involved bytes, the copy lengths by the lower bound of the
+ *     bucket in bits
+ * stats . snapshot
+ */
+inline std::string bit_stats_json(const BitStats& stats)
+{
+    std::string json;
+    char item[64];
+
+    auto field = [&](const char* name, uint64_t val, const char* sep) {
+        (void)snprintf(item, sizeof(item), "  \"%s\": %llu%s\n", name, (unsigned long long)val, sep);
+        json += item;
+    };
+    auto histogram = [&](const char* name, int first, int cnt, bool pow2) {
+        json += "  \"";
+        json += name;
+        json += "\": {";
+        for (int i = 0; i < cnt; ++i)
+        {
+            (void)snprintf(item, sizeof(item), "%s\"%llu\": %llu", (i == 0) ? " " : ", ",
+                pow2 ? (1ULL << i) : (unsigned long long)(i + 1), (unsigned long long)stats.count[first + i]);
+            json += item;
+        }
+        json += " },\n";
+    };
+
+    json += "{\n";
+    field("threads", stats.threads, ",");
+    histogram("reads", BIT_STATS_READS + 1, 9, false);
+    histogram("writes", BIT_STATS_WRITES + 1, 9, false);
+    field("straddle_reads", stats.count[BIT_STATS_READS + 9], ",");
+    field("straddle_writes", stats.count[BIT_STATS_WRITES + 9], ",");
+    field("padded_reads", stats.count[BIT_STATS_PADDED_READS], ",");
+    field("padded_writes", stats.count[BIT_STATS_PADDED_WRITES], ",");
+    field("bytes_read", stats.count[BIT_STATS_BYTES_READ], ",");
+    field("bytes_reread", stats.count[BIT_STATS_BYTES_REREAD], ",");
+    field("bytes_written", stats.count[BIT_STATS_BYTES_WRITTEN], ",");
+    field("copies", stats.count[BIT_STATS_COPIES], ",");
+    field("copy_bits", stats.count[BIT_STATS_COPY_BITS], ",");
+    histogram("copy_lens", BIT_STATS_COPY_LENS, 32, true);
+    json.erase(json.size() - 2, 1);
+    json += "}\n";
+    return json;
+}
+
+/* write the JSON of the current counters to a file
+ * path .. file name, or nullptr for stdout
+ */
+inline bool bit_stats_dump(const char* path = nullptr)
+{
+    std::string json = bit_stats_json(bit_stats_snapshot());
+    FILE* file = stdout;
+#if defined(_MSC_VER)
+    if (path != nullptr && fopen_s(&file, path, "w") != 0)
+        file = nullptr;
+#else
+    if (path != nullptr)
+        file = fopen(path, "w");
+#endif
+    if (file == nullptr)
+        return false;
+
+    bool ret = (fwrite(json.data(), 1, json.size(), file) == json.size());
+    if (path != nullptr)
+        ret = (fclose(file) == 0) && ret;
+    return ret;
+}
+
+#endif /* __BIT_STATS_H__ */
@@ -0,0 +1,207 @@
+/* bit_stream.h
+ * definitions for reading and writing consecutive bitfields of a buffer
+ * through a 64-bit window, so that the buffer is read and written 8 bytes at
+ * a time.
+ */
+
+#ifndef __BIT_STREAM_H__
+#define __BIT_STREAM_H__
+
+#pragma warning(disable : 26451)
+
+#include <cstddef>
+
+#include "bit_bits.h"
+
+/********************************************************************
+ * BitReader - reads consecutive bitfields of a range of bits. the bits are
+ *     held in a 64-bit window, aligned to the MSB; refill() tops the window
+ *     up to at least 57 bits (or the rest of the range) by a single 8-byte
+ *     load, which advances by whole bytes, so several bitfields can be read
+ *     per refill. the bits of the window past the valid ones are zero, and
+ *     nothing past the byte holding the last bit of the range is read.
+ */
+class BitReader
+{
+public:
+    /* start reading
+     * buf ... source buffer
+     * bit ... bit address of the range
+     * len ... length of the range in bits
+     */
+    BitReader(const void* buf, uint64_t bit, uint64_t len)
+        : next_((const uint8_t*)buf + ADDR(bit)), end_((const uint8_t*)buf + ADDR(bit + len + 7)),
+        end_bit_(bit + len), win_(0), avail_(0), left_(len + OFFSET(bit))
+    {
+        if (len == 0)
+        {
+            end_ = next_;
+            left_ = 0;
+            return;
+        }
+        refill();
+        skip((int)OFFSET(bit));
+    }
+
+    /* bit address following the read bits */
+    uint64_t bit() const { return end_bit_ - left_; }
+
+    /* number of bits left in the range */
+    uint64_t left() const { return left_; }
+
+    /* number of valid bits of the window */
+    int avail() const { return avail_; }
+
+    /* the window, its first valid bit in the MSB */
+    uint64_t window() const { return win_; }
+
+    /* top the window up to 57 - 64 bits, or to the rest of the range */
+    void refill()
+    {
+        if (end_ - next_ >= 8)
+        {
+            const int bytes = (64 - avail_) >> 3;
+            if (bytes != 0)
+            {
+                win_ |= BYTE_64_LOAD(next_, 0) >> avail_;
+                next_ += bytes;
+                avail_ += bytes << 3;
+                if (avail_ < 64)
+                    win_ &= ~(~(uint64_t)0 >> avail_);
+            }
+        }
+        else
+        {
+            for (; avail_ <= 56 && next_ < end_; avail_ += 8)
+                win_ |= (uint64_t)(*next_++) << (56 - avail_);
+        }
+
+        /* the bits past the range in its last byte */
+        if ((uint64_t)avail_ > left_)
+        {
+            avail_ = (int)left_;
+            win_ = (avail_ != 0) ? (win_ & ~(~(uint64_t)0 >> avail_)) : 0;
+        }
+    }
+
+    /* consume bits of the window
+     * len ... number of bits, up to avail()
+     */
+    void skip(int len)
+    {
+        win_ = (len < 64) ? (win_ << len) : 0;
+        avail_ -= len;
+        left_ -= len;
+    }
+
+    /* read a bitfield
+     * len ... length of bitfield (0 - 57), up to left()
+     */
+    uint64_t get(int len)
+    {
+        if (avail_ < len)
+            refill();
+        const uint64_t ret = (len != 0) ? (win_ >> (64 - len)) : 0;
+        skip(len);
+        return ret;
+    }
+
+private:
+    const uint8_t* next_;
+    const uint8_t* end_;
+    uint64_t end_bit_;
+    uint64_t win_;
+    int avail_;
+    uint64_t left_;
+};
+
+/********************************************************************
+ * BitWriter - writes consecutive bitfields starting at a bit address. the
+ *     bitfields are collected in a 64-bit accumulator which is stored as
+ *     soon as it is full; only whole 8-byte words of the output are
+ *     stored, the bits preceding the output in its first byte are kept,
+ *     and the last bits are merged by flush(). nothing past the byte
+ *     holding the last written bit is modified.
+ */
+class BitWriter
+{
+public:
+    /* start writing
+     * buf ... destination buffer
+     * bit ... bit address of the output
+     */
+    BitWriter(void* buf, uint64_t bit)
+        : buf_((uint8_t*)buf), out_((uint8_t*)buf + ADDR(bit)), acc_len_((int)OFFSET(bit))
+    {
+        /* start with the untouched leading bits of the first byte */
+        acc_ = (acc_len_ != 0) ? ((uint64_t)BYTE_8(out_, 0) >> (8 - acc_len_)) : 0;
+    }
+
+    /* bit address following the written bits */
+    uint64_t bit() const
+    {
+        return ((uint64_t)(out_ - buf_) << 3) + acc_len_;
+    }
+
+    /* write a bitfield
+     * val ... value to write
+     * len ... length of bitfield (0 - 64)
+     */
+    void put(uint64_t val, int len)
+    {
+        if (len == 0)
+            return;
+        val &= MASK64(len);
+
+        const int head = 64 - acc_len_;
+        if (len < head)
+        {
+            acc_ = (acc_ << len) | val;
+            acc_len_ += len;
+            return;
+        }
+
+        /* the accumulator is full: store it, keep the rest of 'val' */
+        BYTE_64_STORE(out_, 0, (head == 64) ? val : ((acc_ << head) | (val >> (len - head))));
+        out_ += 8;
+        acc_len_ = len - head;
+        acc_ = (acc_len_ != 0) ? (val & MASK64(acc_len_)) : 0;
+    }
+
+    /* take back the last written bits; a stored word is loaded again
+     * len ... number of bits (0 - 64), up to the number of written bits
+     */
+    void unput(int len)
+    {
+        if (len <= acc_len_)
+        {
+            acc_ = (len < 64) ? (acc_ >> len) : 0;
+            acc_len_ -= len;
+            return;
+        }
+
+        out_ -= 8;
+        const int drop = len - acc_len_;
+        acc_len_ = 64 - drop;
+        acc_ = (acc_len_ != 0) ? (BYTE_64_LOAD(out_, 0) >> drop) : 0;
+    }
+
+    /* write the bits of the accumulator to the buffer; writing may go on
+     *     afterwards
+     * returns the bit address following the written bits
+     */
+    uint64_t flush()
+    {
+        if (acc_len_ > 0)
+            BIT_WBITS(out_, 0, acc_len_, acc_);
+        return bit();
+    }
+
+private:
+    uint8_t* buf_;
+    uint8_t* out_;
+    uint64_t acc_;
+    int acc_len_;
+};
+
+#endif /* __BIT_STREAM_H__ */
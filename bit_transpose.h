@@ -0,0 +1,209 @@
+/* bit_transpose.h
+ * definitions for transposing square bit matrices and for slicing arrays of
+ * bitfields into bit-planes and back.
+ */
+
+#ifndef __BIT_TRANSPOSE_H__
+#define __BIT_TRANSPOSE_H__
+
+#pragma warning(disable : 26451)
+
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+#include "bit_bits.h"
+
+/********************************************************************
+ * Functions for transposing bit matrices.
+ *     the rows of a matrix are stored MSB first, as in a buffer of
+ *     bitfields: row 'r' is the 'r'-th byte (8x8), short (16x16) or long
+ *     long (64x64) and column 'c' is its 'c'-th bit counted from the MSB
+ */
+
+/* transpose an 8x8 bit matrix held in a long long (64 bit); row 0 is its most
+ *     significant byte, as returned by BYTE_64
+ * val ... matrix
+ */
+static inline uint64_t bit_transpose8x8(uint64_t val)
+{
+    uint64_t t;
+    t = (val ^ (val >> 7)) & 0x00AA00AA00AA00AAULL;
+    val ^= t ^ (t << 7);
+    t = (val ^ (val >> 14)) & 0x0000CCCC0000CCCCULL;
+    val ^= t ^ (t << 14);
+    t = (val ^ (val >> 28)) & 0x00000000F0F0F0F0ULL;
+    val ^= t ^ (t << 28);
+    return val;
+}
+
+/* transpose eight 8x8 bit matrices in place; GF2P8AFFINEQB with the
+ *     matrices as operands on AVX-512 + GFNI, bit_transpose8x8 otherwise
+ * mat ... array of 8 matrices, each as for bit_transpose8x8
+ */
+static inline void bit_transpose8x8_x8(uint64_t* mat)
+{
+#if defined(__GFNI__) && defined(__AVX512F__) && defined(__AVX512BW__)
+    /* reverse the rows so that byte 'i' of each operand is row 'i', then
+     *     the affine transform of the unit vectors yields the columns
+     */
+    const __m512i bswap = _mm512_set_epi64(
+        0x08090a0b0c0d0e0fLL, 0x0001020304050607LL, 0x08090a0b0c0d0e0fLL, 0x0001020304050607LL,
+        0x08090a0b0c0d0e0fLL, 0x0001020304050607LL, 0x08090a0b0c0d0e0fLL, 0x0001020304050607LL);
+    const __m512i unit = _mm512_set1_epi64(0x8040201008040201LL);
+
+    __m512i rows = _mm512_shuffle_epi8(_mm512_loadu_si512((const void*)mat), bswap);
+    _mm512_storeu_si512((void*)mat, _mm512_gf2p8affine_epi64_epi8(unit, rows, 0));
+#else
+    for (int i = 0; i < 8; ++i)
+        mat[i] = bit_transpose8x8(mat[i]);
+#endif
+}
+
+/* transpose a 16x16 bit matrix in place; 16 SSE2 movemasks of the rows,
+ *     or four 8x8 SWAR blocks without SSE2
+ * rows .. array of 16 rows
+ */
+static inline void bit_transpose16x16(uint16_t* rows)
+{
+#if defined(__SSE2__) || defined(_M_X64)
+    /* byte 'i' holds row '15 - i', so bit 'i' of a movemask is row '15 - i' */
+    __m128i lo = _mm_setr_epi16((short)rows[15], (short)rows[14], (short)rows[13], (short)rows[12],
+        (short)rows[11], (short)rows[10], (short)rows[9], (short)rows[8]);
+    __m128i hi = _mm_setr_epi16((short)rows[7], (short)rows[6], (short)rows[5], (short)rows[4],
+        (short)rows[3], (short)rows[2], (short)rows[1], (short)rows[0]);
+    const __m128i low_bytes = _mm_set1_epi16(0x00FF);
+
+    __m128i left = _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+    __m128i right = _mm_packus_epi16(_mm_and_si128(lo, low_bytes), _mm_and_si128(hi, low_bytes));
+
+    for (int c = 0; c < 8; ++c)
+    {
+        rows[c] = (uint16_t)_mm_movemask_epi8(left);
+        rows[c + 8] = (uint16_t)_mm_movemask_epi8(right);
+        left = _mm_add_epi8(left, left);
+        right = _mm_add_epi8(right, right);
+    }
+#else
+    /* blocks (R, C) of 8x8 bits; transposing swaps blocks (0, 1) and (1, 0) */
+    uint64_t block[2][2] = { { 0, 0 }, { 0, 0 } };
+    for (int r = 0; r < 8; ++r)
+    {
+        block[0][0] = (block[0][0] << 8) | (uint64_t)(rows[r] >> 8);
+        block[0][1] = (block[0][1] << 8) | (uint64_t)(rows[r] & 0xFF);
+        block[1][0] = (block[1][0] << 8) | (uint64_t)(rows[r + 8] >> 8);
+        block[1][1] = (block[1][1] << 8) | (uint64_t)(rows[r + 8] & 0xFF);
+    }
+
+    uint64_t t00 = bit_transpose8x8(block[0][0]), t01 = bit_transpose8x8(block[1][0]);
+    uint64_t t10 = bit_transpose8x8(block[0][1]), t11 = bit_transpose8x8(block[1][1]);
+    for (int r = 0; r < 8; ++r)
+    {
+        int shift = 56 - 8 * r;
+        rows[r] = (uint16_t)((((t00 >> shift) & 0xFF) << 8) | ((t01 >> shift) & 0xFF));
+        rows[r + 8] = (uint16_t)((((t10 >> shift) & 0xFF) << 8) | ((t11 >> shift) & 0xFF));
+    }
+#endif
+}
+
+/* transpose a 64x64 bit matrix in place by SWAR swaps of 32, 16, ... 1 bit
+ *     blocks
+ * rows .. array of 64 rows
+ */
+static inline void bit_transpose64x64(uint64_t* rows)
+{
+    uint64_t mask = 0x00000000FFFFFFFFULL;
+    for (int j = 32; j != 0; j >>= 1, mask ^= (mask << j))
+    {
+        for (int k = 0; k < 64; k = ((k | j) + 1) & ~j)
+        {
+            uint64_t t = (rows[k] ^ (rows[k | j] >> j)) & mask;
+            rows[k] ^= t;
+            rows[k | j] ^= (t << j);
+        }
+    }
+}
+
+/********************************************************************
+ * Functions for slicing consecutive bitfields into bit-planes and back.
+ *     bit-plane 'p' holds bit 'p' (counted from the MSB) of every value, as
+ *     a bitstream of 'n' bits starting at the byte 'planes + p * stride'.
+ *     the values are processed 64 at a time by bit_transpose64x64; the
+ *     bits past 'n' of the last byte of each plane are written as zero.
+ */
+
+/* slice 'n' consecutive bitfields with length 'len' into 'len' bit-planes
+ * buf ..... source buffer
+ * bit ..... bit address of the first bitfield
+ * len ..... length of each bitfield (1 - 64)
+ * n ....... number of values
+ * planes .. destination buffer of the bit-planes
+ * stride .. distance of consecutive bit-planes in bytes, at least (n + 7) / 8
+ */
+template<typename _BufTy, typename _BitTy>
+static inline void to_bitplanes(_BufTy buf, _BitTy bit, int len, std::size_t n, void* planes, std::size_t stride)
+{
+    uint64_t rows[64];
+    uint8_t* out = (uint8_t*)planes;
+
+    for (std::size_t base = 0; base < n; base += 64)
+    {
+        std::size_t cnt = (n - base < 64) ? (n - base) : 64;
+        bit_unpack(buf, (uint64_t)bit + (uint64_t)base * len, len, rows, cnt);
+        for (std::size_t r = 0; r < 64; ++r)
+            rows[r] = (r < cnt) ? (rows[r] << (64 - len)) : 0;
+
+        bit_transpose64x64(rows);
+
+        std::size_t off = base >> 3;
+        int bytes = (int)((cnt + 7) >> 3);
+        for (int p = 0; p < len; ++p)
+        {
+            if (bytes == 8)
+                BYTE_64_STORE(out + p * stride, off, rows[p]);
+            else
+                BYTE_WBYTES(out + p * stride + off, bytes, rows[p] >> (64 - 8 * bytes));
+        }
+    }
+}
+
+/* assemble 'n' consecutive bitfields with length 'len' from 'len' bit-planes
+ * planes .. source buffer of the bit-planes
+ * stride .. distance of consecutive bit-planes in bytes
+ * len ..... length of each bitfield (1 - 64)
+ * n ....... number of values
+ * buf ..... destination buffer
+ * bit ..... bit address of the first bitfield
+ */
+template<typename _BufTy, typename _BitTy>
+static inline void from_bitplanes(const void* planes, std::size_t stride, int len, std::size_t n, _BufTy buf, _BitTy bit)
+{
+    uint64_t rows[64];
+    const uint8_t* in = (const uint8_t*)planes;
+
+    for (std::size_t base = 0; base < n; base += 64)
+    {
+        std::size_t cnt = (n - base < 64) ? (n - base) : 64;
+        std::size_t off = base >> 3;
+        int bytes = (int)((cnt + 7) >> 3);
+        for (int p = 0; p < 64; ++p)
+        {
+            if (p >= len)
+                rows[p] = 0;
+            else if (bytes == 8)
+                rows[p] = BYTE_64_LOAD(in + p * stride, off);
+            else
+                rows[p] = byte_bytes<uint64_t>(in + p * stride + off, bytes) << (64 - 8 * bytes);
+        }
+
+        bit_transpose64x64(rows);
+
+        for (std::size_t r = 0; r < cnt; ++r)
+            rows[r] >>= (64 - len);
+        bit_pack(buf, (uint64_t)bit + (uint64_t)base * len, len, rows, cnt);
+    }
+}
+
+#endif /* __BIT_TRANSPOSE_H__ */
@@ -8,6 +8,7 @@
 
 #pragma warning(disable : 26451)
 
+#include <stdlib.h>
 #include <string.h>
 
 typedef signed char        int8_t;
@@ -45,6 +46,138 @@ typedef unsigned long long uint64_t;
  */
 #define BYTE_8_REF(buf,off) (*((uint8_t*)(buf)+(off)))
 
+/********************************************************************
+ * functions for loading and storing 8 bytes with a single unaligned access
+ */
+
+/* number of bytes a 'padded' buffer must keep readable (and writable, if it is
+ *     written) past its last used byte, so that every access to it can be done
+ *     by a single unaligned 8-byte load or store
+ */
+#define BYTE_PADDING 8
+
+/* reverse the byte order of a 16, 32 or 64 bit value */
+#if defined(_MSC_VER)
+#define BYTE_SWAP16(val) _byteswap_ushort((unsigned short)(val))
+#define BYTE_SWAP32(val) _byteswap_ulong((unsigned long)(val))
+#define BYTE_SWAP64(val) _byteswap_uint64((unsigned long long)(val))
+#else
+#define BYTE_SWAP16(val) __builtin_bswap16((uint16_t)(val))
+#define BYTE_SWAP32(val) __builtin_bswap32((uint32_t)(val))
+#define BYTE_SWAP64(val) __builtin_bswap64((uint64_t)(val))
+#endif
+
+/* true if the host stores integers with big-endian representation */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define BYTE_HOST_BIG_ENDIAN 1
+#else
+#define BYTE_HOST_BIG_ENDIAN 0
+#endif
+
+/* load 8 bytes with host representation by a single unaligned load */
+static inline uint64_t byte_load64(const void* buf)
+{
+    uint64_t ret;
+    (void)memcpy(&ret, buf, 8);
+    return ret;
+}
+
+/* load 2 bytes with host representation by a single unaligned load */
+static inline uint16_t byte_load16(const void* buf)
+{
+    uint16_t ret;
+    (void)memcpy(&ret, buf, 2);
+    return ret;
+}
+
+/* load 4 bytes with host representation by a single unaligned load */
+static inline uint32_t byte_load32(const void* buf)
+{
+    uint32_t ret;
+    (void)memcpy(&ret, buf, 4);
+    return ret;
+}
+
+/* store 8 bytes with host representation by a single unaligned store */
+static inline void byte_store64(void* buf, uint64_t val)
+{
+    (void)memcpy(buf, &val, 8);
+}
+
+/* extract a long long (64 bit, 8 byte) with big-endian representation by a
+ *     single unaligned load, equivalent to BYTE_64
+ * buf ... buffer
+ * off ... byte offset
+ */
+#if BYTE_HOST_BIG_ENDIAN
+#define BYTE_64_LOAD(buf,off) byte_load64((const uint8_t*)(buf)+(off))
+#else
+#define BYTE_64_LOAD(buf,off) ((uint64_t)BYTE_SWAP64(byte_load64((const uint8_t*)(buf)+(off))))
+#endif
+
+/* extract a short (16 bit, 2 byte) and a long (32 bit, 4 byte) with
+ *     big-endian representation by a single unaligned load, equivalent to
+ *     BYTE_16 and BYTE_32
+ * buf ... buffer
+ * off ... byte offset
+ */
+#if BYTE_HOST_BIG_ENDIAN
+#define BYTE_16_LOAD(buf,off) ((uint32_t)byte_load16((const uint8_t*)(buf)+(off)))
+#define BYTE_32_LOAD(buf,off) ((uint32_t)byte_load32((const uint8_t*)(buf)+(off)))
+#else
+#define BYTE_16_LOAD(buf,off) ((uint32_t)BYTE_SWAP16(byte_load16((const uint8_t*)(buf)+(off))))
+#define BYTE_32_LOAD(buf,off) ((uint32_t)BYTE_SWAP32(byte_load32((const uint8_t*)(buf)+(off))))
+#endif
+
+/* extract a short (16 bit, 2 byte) and a long (32 bit, 4 byte) with
+ *     little-endian representation by a single unaligned load, equivalent to
+ *     BYTE_16LE and BYTE_32LE
+ * buf ... buffer
+ * off ... byte offset
+ */
+#if BYTE_HOST_BIG_ENDIAN
+#define BYTE_16LE_LOAD(buf,off) ((uint32_t)BYTE_SWAP16(byte_load16((const uint8_t*)(buf)+(off))))
+#define BYTE_32LE_LOAD(buf,off) ((uint32_t)BYTE_SWAP32(byte_load32((const uint8_t*)(buf)+(off))))
+#else
+#define BYTE_16LE_LOAD(buf,off) ((uint32_t)byte_load16((const uint8_t*)(buf)+(off)))
+#define BYTE_32LE_LOAD(buf,off) ((uint32_t)byte_load32((const uint8_t*)(buf)+(off)))
+#endif
+
+/* extract a long long (64 bit, 8 byte) with little-endian representation by a
+ *     single unaligned load, equivalent to BYTE_64LE
+ * buf ... buffer
+ * off ... byte offset
+ */
+#if BYTE_HOST_BIG_ENDIAN
+#define BYTE_64LE_LOAD(buf,off) ((uint64_t)BYTE_SWAP64(byte_load64((const uint8_t*)(buf)+(off))))
+#else
+#define BYTE_64LE_LOAD(buf,off) byte_load64((const uint8_t*)(buf)+(off))
+#endif
+
+/* write a long long (64 bit, 8 byte) with big-endian representation by a
+ *     single unaligned store
+ * buf ... buffer
+ * off ... byte offset
+ * val ... value to write
+ */
+#if BYTE_HOST_BIG_ENDIAN
+#define BYTE_64_STORE(buf,off,val) byte_store64((uint8_t*)(buf)+(off), (uint64_t)(val))
+#else
+#define BYTE_64_STORE(buf,off,val) byte_store64((uint8_t*)(buf)+(off), (uint64_t)BYTE_SWAP64(val))
+#endif
+
+/* write a long long (64 bit, 8 byte) with little-endian representation by a
+ *     single unaligned store
+ * buf ... buffer
+ * off ... byte offset
+ * val ... value to write
+ */
+#if BYTE_HOST_BIG_ENDIAN
+#define BYTE_64LE_STORE(buf,off,val) byte_store64((uint8_t*)(buf)+(off), (uint64_t)BYTE_SWAP64(val))
+#else
+#define BYTE_64LE_STORE(buf,off,val) byte_store64((uint8_t*)(buf)+(off), (uint64_t)(val))
+#endif
+
 /********************************************************************
  * functions for extracting bytes with big-endian representation
  */
@@ -173,6 +306,28 @@ static inline _RetTy byte_bytes_inc(_BufTy & buf, _LenTy len)
     return ret;
 }
 
+/* extract bytes with a length up to 8 byte known at compile time with
+ *     big-endian representation; 2, 4 and 8 bytes are a single load and a
+ *     byte swap (MOVBE)
+ * buf ... buffer
+ */
+template<int _N, typename _BufTy>
+static inline uint64_t byte_bytes(_BufTy buf)
+{
+    static_assert(_N >= 1 && _N <= 8, "byte_bytes<N>: 1 - 8 bytes");
+    switch (_N)
+    {
+    case 1: return BYTE_8(buf, 0);
+    case 2: return BYTE_16_LOAD(buf, 0);
+    case 3: return BYTE_24(buf, 0);
+    case 4: return BYTE_32_LOAD(buf, 0);
+    case 5: return BYTE_40(buf, 0);
+    case 6: return BYTE_48(buf, 0);
+    case 7: return BYTE_56(buf, 0);
+    default: return BYTE_64_LOAD(buf, 0);
+    }
+}
+
 /********************************************************************
  * Functions for extracting bytes with custom length from a source to a
  *     destination buffer
@@ -328,6 +483,27 @@ static inline _RetTy byte_bytes_le_inc(_BufTy & buf, _LenTy len)
     return ret;
 }
 
+/* extract bytes with a length up to 8 byte known at compile time with
+ *     little-endian representation; 2, 4 and 8 bytes are a single load
+ * buf ... buffer
+ */
+template<int _N, typename _BufTy>
+static inline uint64_t byte_bytes_le(_BufTy buf)
+{
+    static_assert(_N >= 1 && _N <= 8, "byte_bytes_le<N>: 1 - 8 bytes");
+    switch (_N)
+    {
+    case 1: return BYTE_8(buf, 0);
+    case 2: return BYTE_16LE_LOAD(buf, 0);
+    case 3: return BYTE_24LE(buf, 0);
+    case 4: return BYTE_32LE_LOAD(buf, 0);
+    case 5: return BYTE_40LE(buf, 0);
+    case 6: return BYTE_48LE(buf, 0);
+    case 7: return BYTE_56LE(buf, 0);
+    default: return BYTE_64LE_LOAD(buf, 0);
+    }
+}
+
 /********************************************************************
  * Functions for writing value to a destination buffer with big-endian representation
  */
@@ -400,6 +576,126 @@ static inline _RetTy byte_bytes_le_inc(_BufTy & buf, _LenTy len)
         BYTE_INCREMENT(buf, len); \
     } while (0)
 
+/********************************************************************
+ * functions for accessing bytes of padded buffers with a single unaligned
+ *     64-bit load (and store) and no branch on the length; the buffer must
+ *     provide 8 bytes from the first byte, i.e. BYTE_PADDING bytes past the
+ *     last byte
+ */
+
+/* extract bytes with custom length of 1 - 8 byte with big-endian representation
+ *     from a padded buffer
+ * buf ... buffer
+ * len ... number of bytes
+ */
+#define BYTE_PADDED(buf,len) \
+    (BYTE_64_LOAD(buf, 0) >> (64 - ((len) << 3)))
+
+/* extract bytes with custom length of 1 - 8 byte with little-endian
+ *     representation from a padded buffer
+ * buf ... buffer
+ * len ... number of bytes
+ */
+#define BYTE_PADDED_LE(buf,len) \
+    (BYTE_64LE_LOAD(buf, 0) & (~(uint64_t)0 >> (64 - ((len) << 3))))
+
+/* extract bytes with custom length of 1 - 8 byte with big-endian representation
+ *     from a padded buffer
+ * buf ... buffer
+ * len ... number of bytes
+ * ret ... result variable
+ */
+#define BYTE_BYTES_PADDED(buf,len,ret) \
+    do { \
+        (ret) = BYTE_PADDED(buf, len); \
+    } while (0)
+
+/* extract bytes with custom length of 1 - 8 byte with big-endian representation
+ *     from a padded buffer and increment buffer pointer 'buf'
+ * buf ... buffer
+ * len ... number of bytes
+ * ret ... result variable
+ */
+#define BYTE_BYTES_PADDED_INC(buf,len,ret) \
+    do { \
+        BYTE_BYTES_PADDED(buf, len, ret); \
+        BYTE_INCREMENT(buf, len); \
+    } while (0)
+
+/* extract bytes with custom length of 1 - 8 byte with little-endian
+ *     representation from a padded buffer
+ * buf ... buffer
+ * len ... number of bytes
+ * ret ... result variable
+ */
+#define BYTE_BYTES_LE_PADDED(buf,len,ret) \
+    do { \
+        (ret) = BYTE_PADDED_LE(buf, len); \
+    } while (0)
+
+/* extract bytes with custom length of 1 - 8 byte with little-endian
+ *     representation from a padded buffer and increment buffer pointer 'buf'
+ * buf ... buffer
+ * len ... number of bytes
+ * ret ... result variable
+ */
+#define BYTE_BYTES_LE_PADDED_INC(buf,len,ret) \
+    do { \
+        BYTE_BYTES_LE_PADDED(buf, len, ret); \
+        BYTE_INCREMENT(buf, len); \
+    } while (0)
+
+/* write value to a padded destination buffer with custom length of 1 - 8 byte
+ *     with big-endian representation; the bytes following it are kept
+ * buf ... destination buffer
+ * len ... number of bytes
+ * val ... value to write
+ */
+#define BYTE_WBYTES_PADDED(buf,len,val) \
+    do { \
+        int __shift__ = 64 - ((len) << 3); \
+        uint64_t __mask__ = ~(uint64_t)0 << __shift__; \
+        uint64_t __word__ = BYTE_64_LOAD(buf, 0); \
+        BYTE_64_STORE(buf, 0, (__word__ & ~__mask__) | ((uint64_t)(val) << __shift__)); \
+    } while (0)
+
+/* write value to a padded destination buffer with custom length of 1 - 8 byte
+ *     with big-endian representation and increment buffer pointer 'buf'
+ * buf ... destination buffer
+ * len ... number of bytes
+ * val ... value to write
+ */
+#define BYTE_WBYTES_PADDED_INC(buf,len,val) \
+    do { \
+        BYTE_WBYTES_PADDED(buf, len, val); \
+        BYTE_INCREMENT(buf, len); \
+    } while (0)
+
+/* write value to a padded destination buffer with custom length of 1 - 8 byte
+ *     with little-endian representation; the bytes following it are kept
+ * buf ... destination buffer
+ * len ... number of bytes
+ * val ... value to write
+ */
+#define BYTE_WBYTES_LE_PADDED(buf,len,val) \
+    do { \
+        uint64_t __mask__ = ~(uint64_t)0 >> (64 - ((len) << 3)); \
+        uint64_t __word__ = BYTE_64LE_LOAD(buf, 0); \
+        BYTE_64LE_STORE(buf, 0, (__word__ & ~__mask__) | ((uint64_t)(val) & __mask__)); \
+    } while (0)
+
+/* write value to a padded destination buffer with custom length of 1 - 8 byte
+ *     with little-endian representation and increment buffer pointer 'buf'
+ * buf ... destination buffer
+ * len ... number of bytes
+ * val ... value to write
+ */
+#define BYTE_WBYTES_LE_PADDED_INC(buf,len,val) \
+    do { \
+        BYTE_WBYTES_LE_PADDED(buf, len, val); \
+        BYTE_INCREMENT(buf, len); \
+    } while (0)
+
 /********************************************************************
  * Functions for writing bytes with custom length from a source to a
  *     destination buffer
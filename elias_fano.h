@@ -0,0 +1,238 @@
+/* elias_fano.h
+ * definitions of a container for ascending sequences of values, e.g. sorted
+ * offsets and posting lists, in the Elias-Fano representation: about
+ * 2 + log2(universe / size) bits per value, with random access and search.
+ */
+
+#ifndef __ELIAS_FANO_H__
+#define __ELIAS_FANO_H__
+
+#pragma warning(disable : 26451)
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+#include "bit_bits.h"
+#include "bit_extract.h"
+#include "bit_stream.h"
+
+/* distance of the sampled ones and zeros of the upper bits (skip pointers) */
+#define ELIAS_FANO_SAMPLE 256
+
+/********************************************************************
+ * EliasFano - ascending sequence of 'size()' values below 2^64 - 1. the
+ *     'low_len()' low bits of every value are stored back to back as
+ *     bitfields of a padded buffer; the upper bits of value 'i' are stored
+ *     as the set bit '(value >> low_len()) + i' of a bitvector (from the
+ *     LSB of its 64-bit words), i.e. in unary. the positions of every
+ *     ELIAS_FANO_SAMPLE-th one and zero of the bitvector are sampled, so a
+ *     value or a bucket of values is found by a jump to the sample, a scan
+ *     of a few words by popcount and a select within a word.
+ */
+class EliasFano
+{
+public:
+    typedef uint64_t value_type;
+    typedef std::size_t size_type;
+
+    /* forward iterator over the values; every step finds the next set bit
+     *     of the upper bits
+     */
+    class const_iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef EliasFano::value_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef value_type reference;
+        typedef void pointer;
+
+        const_iterator() : ef_(nullptr), idx_(0), pos_(0) {}
+        const_iterator(const EliasFano* ef, size_type idx, uint64_t pos) : ef_(ef), idx_(idx), pos_(pos) {}
+
+        /* index of the value */
+        size_type index() const { return idx_; }
+
+        value_type operator*() const { return ef_->value(idx_, pos_); }
+
+        const_iterator& operator++()
+        {
+            if (++idx_ < ef_->size_)
+                pos_ = ef_->next_one(pos_ + 1);
+            return *this;
+        }
+
+        const_iterator operator++(int) { const_iterator ret = *this; ++(*this); return ret; }
+
+        bool operator==(const const_iterator& other) const { return idx_ == other.idx_; }
+        bool operator!=(const const_iterator& other) const { return idx_ != other.idx_; }
+
+    private:
+        const EliasFano* ef_;
+        size_type idx_;
+        uint64_t pos_;
+    };
+
+    typedef const_iterator iterator;
+
+    EliasFano() : size_(0), low_len_(0), universe_(0) {}
+
+    /* build the sequence of 'n' ascending values of array 'src' */
+    template<typename _ValTy>
+    EliasFano(const _ValTy* src, size_type n) : size_(n), low_len_(0), universe_(0)
+    {
+        if (n == 0)
+            return;
+
+        universe_ = (uint64_t)src[n - 1] + 1;
+        if (universe_ / n > 1)
+            low_len_ = 63 - bit_clz64(universe_ / n);
+
+        /* the low bits, written by a BitWriter */
+        low_.assign((size_type)ADDR((uint64_t)n * low_len_ + 7) + BYTE_PADDING, 0);
+        BitWriter low(low_.data(), 0);
+        for (size_type i = 0; i < n; ++i)
+            low.put((uint64_t)src[i], low_len_);
+        low.flush();
+
+        /* the upper bits and the samples of the ones */
+        const uint64_t high_bits = (uint64_t)n + (universe_ >> low_len_) + 1;
+        high_.assign((size_type)((high_bits + 63) >> 6) + 1, 0);
+        for (size_type i = 0; i < n; ++i)
+        {
+            const uint64_t pos = ((uint64_t)src[i] >> low_len_) + i;
+            high_[pos >> 6] |= (uint64_t)1 << (pos & 63);
+            if (i % ELIAS_FANO_SAMPLE == 0)
+                ones_.push_back(pos);
+        }
+
+        /* the samples of the zeros */
+        uint64_t zeros = 0;
+        for (size_type w = 0; (uint64_t)w << 6 < high_bits; ++w)
+        {
+            uint64_t word = ~high_[w];
+            const int cnt = bit_popcount64(word);
+            while (zeros + cnt > (uint64_t)zeros_.size() * ELIAS_FANO_SAMPLE)
+            {
+                const int r = (int)((uint64_t)zeros_.size() * ELIAS_FANO_SAMPLE - zeros);
+                zeros_.push_back(((uint64_t)w << 6) + bit_select64(word, r));
+            }
+            zeros += cnt;
+        }
+    }
+
+    size_type size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    /* number of low bits of a value stored as a bitfield */
+    int low_len() const { return low_len_; }
+
+    /* number of bits of the storage, including samples and padding */
+    uint64_t bit_size() const
+    {
+        return ((uint64_t)low_.size() << 3) + ((uint64_t)(high_.size() + ones_.size() + zeros_.size()) << 6);
+    }
+
+    /* extract value 'idx' */
+    value_type get(size_type idx) const
+    {
+        return value(idx, select1(idx));
+    }
+
+    value_type operator[](size_type idx) const { return get(idx); }
+
+    /* find the first value not less than 'x'
+     * returns its index, or 'size()' if all values are less than 'x'
+     */
+    size_type next_geq(value_type x) const
+    {
+        return lower_bound(x).index();
+    }
+
+    /* iterator at the first value not less than 'x', or end() */
+    const_iterator lower_bound(value_type x) const
+    {
+        if (x >= universe_)
+            return end();
+
+        /* the first value of bucket 'x >> low_len()' follows zero 'bucket - 1' */
+        const uint64_t bucket = x >> low_len_;
+        const uint64_t start = (bucket == 0) ? 0 : (select0(bucket - 1) + 1);
+        const_iterator it(this, (size_type)(start - bucket), next_one(start));
+        while (*it < x)
+            ++it;
+        return it;
+    }
+
+    const_iterator begin() const { return const_iterator(this, 0, (size_ != 0) ? select1(0) : 0); }
+    const_iterator end() const { return const_iterator(this, size_, 0); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+private:
+    /* the value 'idx' with the set bit of its upper bits at 'pos' */
+    value_type value(size_type idx, uint64_t pos) const
+    {
+        uint64_t low = 0;
+        if (low_len_ != 0)
+        {
+            const uint64_t bit = (uint64_t)idx * low_len_;
+            if (low_len_ <= BIT_PADDED_MAX_LEN)
+                low = BIT_PADDED(low_.data(), bit, low_len_);
+            else
+                BIT_BITS(low_.data(), bit, low_len_, low);
+        }
+        return ((pos - idx) << low_len_) | low;
+    }
+
+    /* position of the first set bit at or after 'pos' */
+    uint64_t next_one(uint64_t pos) const
+    {
+        size_type w = (size_type)(pos >> 6);
+        uint64_t word = high_[w] & (~(uint64_t)0 << (pos & 63));
+        while (word == 0)
+            word = high_[++w];
+        return ((uint64_t)w << 6) + bit_ctz64(word);
+    }
+
+    /* position of the set bit 'idx' */
+    uint64_t select1(size_type idx) const
+    {
+        const uint64_t pos = ones_[idx / ELIAS_FANO_SAMPLE];
+        int r = (int)(idx % ELIAS_FANO_SAMPLE);
+        size_type w = (size_type)(pos >> 6);
+        uint64_t word = high_[w] & (~(uint64_t)0 << (pos & 63));
+        for (int cnt = bit_popcount64(word); r >= cnt; cnt = bit_popcount64(word))
+        {
+            r -= cnt;
+            word = high_[++w];
+        }
+        return ((uint64_t)w << 6) + bit_select64(word, r);
+    }
+
+    /* position of the zero bit 'idx' */
+    uint64_t select0(uint64_t idx) const
+    {
+        const uint64_t pos = zeros_[(size_type)(idx / ELIAS_FANO_SAMPLE)];
+        int r = (int)(idx % ELIAS_FANO_SAMPLE);
+        size_type w = (size_type)(pos >> 6);
+        uint64_t word = ~high_[w] & (~(uint64_t)0 << (pos & 63));
+        for (int cnt = bit_popcount64(word); r >= cnt; cnt = bit_popcount64(word))
+        {
+            r -= cnt;
+            word = ~high_[++w];
+        }
+        return ((uint64_t)w << 6) + bit_select64(word, r);
+    }
+
+    size_type size_;
+    int low_len_;
+    uint64_t universe_;
+    std::vector<uint8_t> low_;
+    std::vector<uint64_t> high_;
+    std::vector<uint64_t> ones_;
+    std::vector<uint64_t> zeros_;
+};
+
+#endif /* __ELIAS_FANO_H__ */
@@ -0,0 +1,246 @@
+/* packed_array.h
+ * definitions of a container for arrays of values with a fixed bit-length,
+ * stored back to back as consecutive bitfields.
+ */
+
+#ifndef __PACKED_ARRAY_H__
+#define __PACKED_ARRAY_H__
+
+#pragma warning(disable : 26451)
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+#include "bit_bits.h"
+
+/********************************************************************
+ * PackedArray - array of 'size()' values of 'width()' bits each (1 - 64).
+ *     value 'i' is the bitfield at bit address 'i * width()' of 'data()',
+ *     so the storage can be read and written with BIT_BITS/BIT_WBITS as well.
+ *     the storage is a vector of 64-bit words with one word of padding, so
+ *     every field up to BIT_PADDED_MAX_LEN bits is accessed by a single
+ *     unaligned 64-bit load (and store).
+ * _Width ... bit-length of values, or 0 to set it at runtime by constructor
+ */
+template<int _Width = 0>
+class PackedArray
+{
+    static_assert(_Width >= 0 && _Width <= 64, "PackedArray: width must be 0 (runtime) or 1 - 64");
+
+public:
+    typedef uint64_t value_type;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    /* proxy reference to a single value of the array */
+    class reference
+    {
+    public:
+        reference(PackedArray* arr, size_type idx) : arr_(arr), idx_(idx) {}
+
+        operator value_type() const { return arr_->get(idx_); }
+
+        reference& operator=(value_type val)
+        {
+            arr_->set(idx_, val);
+            return *this;
+        }
+
+        reference& operator=(const reference& other)
+        {
+            arr_->set(idx_, (value_type)other);
+            return *this;
+        }
+
+    private:
+        PackedArray* arr_;
+        size_type idx_;
+    };
+
+    /* random access iterator over the values of the array */
+    template<bool _Const>
+    class basic_iterator
+    {
+        typedef typename std::conditional<_Const, const PackedArray, PackedArray>::type array_type;
+
+    public:
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef PackedArray::value_type value_type;
+        typedef PackedArray::difference_type difference_type;
+        typedef typename std::conditional<_Const, PackedArray::value_type, PackedArray::reference>::type reference;
+        typedef void pointer;
+
+        basic_iterator() : arr_(nullptr), idx_(0) {}
+        basic_iterator(array_type* arr, size_type idx) : arr_(arr), idx_(idx) {}
+
+        /* non-const to const conversion */
+        operator basic_iterator<true>() const { return basic_iterator<true>(arr_, idx_); }
+
+        reference operator*() const { return (*arr_)[idx_]; }
+        reference operator[](difference_type off) const { return (*arr_)[idx_ + off]; }
+
+        basic_iterator& operator++() { ++idx_; return *this; }
+        basic_iterator& operator--() { --idx_; return *this; }
+        basic_iterator operator++(int) { basic_iterator ret = *this; ++idx_; return ret; }
+        basic_iterator operator--(int) { basic_iterator ret = *this; --idx_; return ret; }
+        basic_iterator& operator+=(difference_type off) { idx_ += off; return *this; }
+        basic_iterator& operator-=(difference_type off) { idx_ -= off; return *this; }
+
+        basic_iterator operator+(difference_type off) const { return basic_iterator(arr_, idx_ + off); }
+        basic_iterator operator-(difference_type off) const { return basic_iterator(arr_, idx_ - off); }
+        friend basic_iterator operator+(difference_type off, const basic_iterator& it) { return it + off; }
+        difference_type operator-(const basic_iterator& other) const { return (difference_type)idx_ - (difference_type)other.idx_; }
+
+        bool operator==(const basic_iterator& other) const { return idx_ == other.idx_; }
+        bool operator!=(const basic_iterator& other) const { return idx_ != other.idx_; }
+        bool operator<(const basic_iterator& other) const { return idx_ < other.idx_; }
+        bool operator>(const basic_iterator& other) const { return idx_ > other.idx_; }
+        bool operator<=(const basic_iterator& other) const { return idx_ <= other.idx_; }
+        bool operator>=(const basic_iterator& other) const { return idx_ >= other.idx_; }
+
+    private:
+        array_type* arr_;
+        size_type idx_;
+    };
+
+    typedef basic_iterator<false> iterator;
+    typedef basic_iterator<true> const_iterator;
+
+    /* array with compile-time width
+     * size .. number of values
+     */
+    explicit PackedArray(size_type size = 0) : width_(_Width), size_(0)
+    {
+        static_assert(_Width != 0, "PackedArray<0>: width must be passed to the constructor");
+        resize(size);
+    }
+
+    /* array with runtime width
+     * size .. number of values
+     * width . bit-length of values (1 - 64), equal to '_Width' unless it is 0
+     */
+    PackedArray(size_type size, int width) : width_(_Width ? _Width : width), size_(0)
+    {
+        assert(width >= 1 && width <= 64);
+        assert(_Width == 0 || width == _Width);
+        resize(size);
+    }
+
+    int width() const { return _Width ? _Width : width_; }
+    size_type size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    /* largest value which fits in 'width()' bits */
+    value_type max_value() const { return MASK64(width()); }
+
+    /* storage as a buffer of bitfields for the BIT_* functions */
+    const uint8_t* data() const { return (const uint8_t*)words_.data(); }
+    uint8_t* data() { return (uint8_t*)words_.data(); }
+
+    /* number of bytes holding the values (without padding) */
+    size_type byte_size() const { return (size_type)ADDR((uint64_t)size_ * width() + 7); }
+
+    /* change the number of values; new values are zero */
+    void resize(size_type size)
+    {
+        uint64_t bit_count = (uint64_t)size * width();
+        if (size < size_)
+        {
+            /* keep the bits past the last value clean */
+            uint64_t old_bit_count = (uint64_t)size_ * width();
+            for (uint64_t bit = bit_count; bit < old_bit_count; /*_*/)
+            {
+                int len = (old_bit_count - bit >= 64) ? 64 : (int)(old_bit_count - bit);
+                BIT_WBITS(data(), bit, len, (uint64_t)0);
+                bit += len;
+            }
+        }
+
+        words_.resize((size_type)((bit_count + 63) >> 6) + 1, 0);
+        size_ = size;
+    }
+
+    /* extract value 'idx' */
+    value_type get(size_type idx) const
+    {
+        const uint64_t bit = (uint64_t)idx * width();
+        if (width() <= BIT_PADDED_MAX_LEN)
+            return BIT_PADDED(data(), bit, width());
+
+        value_type ret = 0;
+        BIT_BITS(data(), bit, width(), ret);
+        return ret;
+    }
+
+    /* write value 'idx', bits of 'val' above 'width()' are ignored */
+    void set(size_type idx, value_type val)
+    {
+        const uint64_t bit = (uint64_t)idx * width();
+        if (width() <= BIT_PADDED_MAX_LEN)
+            BIT_WBITS_PADDED(data(), bit, width(), val);
+        else
+            BIT_WBITS(data(), bit, width(), val);
+    }
+
+    value_type operator[](size_type idx) const { return get(idx); }
+    reference operator[](size_type idx) { return reference(this, idx); }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, size_); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size_); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    /* write 'val' to all values; the first 8 values cover 'width()' whole
+     *     bytes, which are then replicated with memcpy
+     */
+    void fill(value_type val)
+    {
+        if (size_ == 0)
+            return;
+
+        const size_type period = (size_type)width();
+        const size_type bytes = byte_size();
+        for (size_type idx = 0; idx < 8 && idx < size_; ++idx)
+            set(idx, val);
+
+        for (size_type done = period; done < bytes; /*_*/)
+        {
+            size_type len = (done <= bytes - done) ? done : (bytes - done);
+            (void)memcpy(data() + done, data(), len);
+            done += len;
+        }
+
+        /* clear the bits past the last value */
+        int tail = (int)OFFSET((uint64_t)size_ * width());
+        if (tail != 0)
+            BIT_W8(data(), ((uint64_t)size_ * width()), 8 - tail, 0);
+    }
+
+    /* replace the content by 'n' values of array 'src' */
+    template<typename _ValTy>
+    void assign(const _ValTy* src, size_type n)
+    {
+        words_.assign((size_type)(((uint64_t)n * width() + 63) >> 6) + 1, 0);
+        size_ = n;
+        bit_pack(data(), 0, width(), src, n);
+    }
+
+    /* extract all values to array 'dst' */
+    template<typename _ValTy>
+    void copy_to(_ValTy* dst) const
+    {
+        bit_unpack(data(), 0, width(), dst, size_);
+    }
+
+private:
+    int width_;
+    size_type size_;
+    std::vector<uint64_t> words_;
+};
+
+#endif /* __PACKED_ARRAY_H__ */